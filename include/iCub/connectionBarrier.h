@@ -0,0 +1,164 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file connectionBarrier.h
+ * @brief Wait at startup until the ports of a module are connected, shared by all the modules.
+ *
+ * All the connections are checked together in each round and the rounds get sparser (backoff), so the
+ * modules still initializing on the same board get the CPU. The missing ones are reported periodically
+ * and, after the timeout, the module fails or starts without the optional (or all, in degraded mode) ones.
+ */
+
+#ifndef _CONNECTIONBARRIER_H_
+#define _CONNECTIONBARRIER_H_
+
+#include <yarp/os/all.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+
+#define CONNECTION_FIRST_POLL       0.01    //s between the first checks, doubled each round
+#define CONNECTION_MAX_POLL         0.5     //s, maximum time between two checks
+#define CONNECTION_REPORT_PERIOD    5.0     //s between two reports of the missing connections
+#define CONNECTION_NO_TIMEOUT       0.0
+#define CONNECTION_OPTIONAL_GRACE   2.0     //s the optional connections are still waited after the required ones, without timeout
+
+typedef struct connectionRequirement_{
+    std::string name;
+    std::function<bool()> connected;
+    bool optional;                          //the module can work without it, it is only waited until the timeout
+}connectionRequirement;
+
+class connectionBarrier{
+    private:
+        std::vector<connectionRequirement> requirements;
+        double timeout;                     //s, CONNECTION_NO_TIMEOUT waits forever for the required ones
+        bool degradedStart;                 //start without the required connections missing at the timeout
+
+        //shared by the barriers of the process (the modules run by the executor)
+        static std::atomic<bool>& aborted(){
+            static std::atomic<bool> flag(false);
+            return flag;
+        }
+
+    public:
+        connectionBarrier(){
+            timeout = CONNECTION_NO_TIMEOUT;
+            degradedStart = false;
+        }
+
+        /**
+        * CONNECTION_TIMEOUT (s, 0 waits forever) and CONNECTION_DEGRADED_START (0/1) of the variables group
+        */
+        void configure(const yarp::os::Bottle& variables){
+            timeout = variables.check("CONNECTION_TIMEOUT", yarp::os::Value(CONNECTION_NO_TIMEOUT)).asFloat64();
+            degradedStart = variables.check("CONNECTION_DEGRADED_START", yarp::os::Value(0)).asInt32() != 0;
+        }
+
+        /**
+        * stop the waits of all the barriers of the process, they return false (a module of the executor failed)
+        */
+        static void abortAll(){
+            aborted() = true;
+        }
+
+        void add(const std::string& name, std::function<bool()> connected, bool optional = false){
+            connectionRequirement requirement;
+            requirement.name = name;
+            requirement.connected = connected;
+            requirement.optional = optional;
+            requirements.push_back(requirement);
+        }
+
+        void addInput(yarp::os::Contactable& port, bool optional = false){
+            add(port.getName(), [&port]{ return port.getInputCount() > 0; }, optional);
+        }
+
+        void addOutput(yarp::os::Contactable& port, bool optional = false){
+            add(port.getName(), [&port]{ return port.getOutputCount() > 0; }, optional);
+        }
+
+        std::vector<std::string> missing(bool onlyRequired = false){
+            std::vector<std::string> names;
+            for(int i = 0; i < requirements.size(); i++)
+                if(!(onlyRequired && requirements[i].optional) && !requirements[i].connected())
+                    names.push_back(requirements[i].name);
+            return names;
+        }
+
+        /**
+        * wait for all the connections (the optional ones only until the timeout, or the grace period without timeout)
+        * @return false if required connections are missing at the timeout and the degraded start is not allowed
+        */
+        bool wait(){
+            double start = yarp::os::Time::now();
+            double lastReport = start;
+            double poll = CONNECTION_FIRST_POLL;
+            double requiredDone = -1;           //time all the required ones were connected
+
+            std::vector<std::string> names = missing();
+            while(!names.empty()){
+                if(aborted()){
+                    yWarning("Stopped waiting for the connections: %s", join(names).c_str());
+                    return false;
+                }
+                double now = yarp::os::Time::now();
+                if(timeout != CONNECTION_NO_TIMEOUT && now - start >= timeout)
+                    break;
+                //without timeout, the optional connections are only waited for a grace period after the required ones
+                if(timeout == CONNECTION_NO_TIMEOUT && requiredDone < 0 && missing(true).empty())
+                    requiredDone = now;
+                if(requiredDone >= 0 && now - requiredDone >= CONNECTION_OPTIONAL_GRACE)
+                    break;
+
+                if(now - lastReport >= CONNECTION_REPORT_PERIOD){
+                    yInfo("Waiting for %d connections: %s", (int)names.size(), join(names).c_str());
+                    lastReport = now;
+                }
+
+                yarp::os::Time::delay(poll);
+                poll = std::min(2.0 * poll, CONNECTION_MAX_POLL);
+                names = missing();
+            }
+
+            if(!names.empty())
+                yWarning("Starting without the connections: %s", join(names).c_str());
+
+            std::vector<std::string> required = missing(true);
+            if(required.empty())
+                return true;
+            if(degradedStart){
+                yWarning("Degraded start, required connections missing: %s", join(required).c_str());
+                return true;
+            }
+            yError("Required connections missing after %.1f s: %s", timeout, join(required).c_str());
+            return false;
+        }
+
+    private:
+        static std::string join(const std::vector<std::string>& names){
+            std::string all;
+            for(int i = 0; i < names.size(); i++)
+                all += (i == 0 ? "" : " ") + names[i];
+            return all;
+        }
+};
+
+#endif  //_CONNECTIONBARRIER_H_
@@ -0,0 +1,301 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file cooperativeExecutor.h
+ * @brief Runs the threads of several modules as tasks of one periodic thread, in a fixed order in each cycle.
+ *
+ * Each task keeps its own period ([periods] group, also adaptive) and runs in the first cycle after it is due, the
+ * cycle is as fast as the fastest task. A task that reads its inputs blocking waits until its producers ticked
+ * again, so with one worker it never waits for data that nobody can write. A task that blocks in its cycle
+ * (decision making waits for the action) can have its own worker: it is started in its place of the order and
+ * the next tasks wait for it until the end of the cycle.
+ */
+
+#ifndef _COOPERATIVEEXECUTOR_H_
+#define _COOPERATIVEEXECUTOR_H_
+
+#include <yarp/os/all.h>
+#include <yarp/os/PeriodicThread.h>
+#include <yarp/os/Thread.h>
+#include <yarp/os/Log.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <iCub/monitoredThread.h>
+#include <iCub/connectionBarrier.h>
+
+#define EXECUTOR_DEFAULT_PERIOD     0.5     //s, only until the tasks are added
+#define EXECUTOR_DUE_MARGIN         0.1     //fraction of the cycle, a task due a bit after the start of the cycle runs in it
+
+//Worker of a task that blocks in its cycle, one cycle for each trigger
+class executorWorker : public yarp::os::Thread {
+    private:
+        monitoredThread* task;
+        std::mutex workerMutex;
+        std::condition_variable workerCondition;
+        bool pending;
+        bool busy;
+
+    public:
+        executorWorker(monitoredThread* _task){
+            task = _task;
+            pending = false;
+            busy = false;
+        }
+
+        void trigger(){
+            std::lock_guard<std::mutex> lock(workerMutex);
+            pending = true;
+            busy = true;
+            workerCondition.notify_all();
+        }
+
+        bool isBusy(){
+            std::lock_guard<std::mutex> lock(workerMutex);
+            return busy;
+        }
+
+        /**
+        * @return false if the cycle is still running at the deadline
+        */
+        bool waitIdle(double deadline){
+            std::unique_lock<std::mutex> lock(workerMutex);
+            double remaining = std::max(deadline - yarp::os::Time::now(), 0.0);
+            return workerCondition.wait_for(lock, std::chrono::duration<double>(remaining), [this]{ return !busy; });
+        }
+
+        void run() override{
+            while(!isStopping()){
+                {
+                    std::unique_lock<std::mutex> lock(workerMutex);
+                    workerCondition.wait(lock, [this]{ return pending || isStopping(); });
+                    if(!pending)
+                        break;
+                    pending = false;
+                }
+                task->runTask();
+                std::lock_guard<std::mutex> lock(workerMutex);
+                busy = false;
+                workerCondition.notify_all();
+            }
+        }
+
+        void onStop() override{
+            std::lock_guard<std::mutex> lock(workerMutex);
+            workerCondition.notify_all();
+        }
+};
+
+typedef struct executorTask_{
+    monitoredThread* thread;
+    std::string name;
+    std::vector<int> producers;                 //tasks (index) whose output it reads blocking
+    std::vector<unsigned int> producerTicks;    //ticks of the producers at its last cycle
+    double nextDue;
+    executorWorker* worker;                     //nullptr: runs in the cycle of the executor
+}executorTask;
+
+class cooperativeExecutor : public yarp::os::PeriodicThread {
+    private:
+        std::vector<executorTask> tasks;
+        bool initialized;
+
+        int find(const std::string& name){
+            for(int i = 0; i < tasks.size(); i++)
+                if(tasks[i].name == name)
+                    return i;
+            return -1;
+        }
+
+        unsigned int ticksOf(int task){
+            return tasks[task].thread->getPeriodStats().ticks;
+        }
+
+        bool producersTicked(executorTask& task){
+            for(int i = 0; i < task.producers.size(); i++)
+                if(ticksOf(task.producers[i]) <= task.producerTicks[i])
+                    return false;
+            return true;
+        }
+
+        bool isDue(executorTask& task, double now){
+            return now >= task.nextDue - EXECUTOR_DUE_MARGIN * getPeriod() && producersTicked(task);
+        }
+
+        void started(executorTask& task, double now){
+            for(int i = 0; i < task.producers.size(); i++)
+                task.producerTicks[i] = ticksOf(task.producers[i]);
+            //late (or waiting for its producers): the next ones are counted from now
+            double period = task.thread->getPeriod();
+            task.nextDue += period;
+            if(task.nextDue < now)
+                task.nextDue = now + period;
+        }
+
+        //the cycle follows the fastest task (the periods are adaptive)
+        void followFastestTask(){
+            double period = tasks.empty() ? EXECUTOR_DEFAULT_PERIOD : tasks[0].thread->getPeriod();
+            for(int i = 1; i < tasks.size(); i++)
+                period = std::min(period, tasks[i].thread->getPeriod());
+            if(period != getPeriod())
+                setPeriod(period);
+        }
+
+        void releaseTasks(int count){
+            for(int i = count - 1; i >= 0; i--)
+                tasks[i].thread->releaseTask();
+        }
+
+    public:
+        cooperativeExecutor():PeriodicThread(EXECUTOR_DEFAULT_PERIOD){
+            initialized = false;
+        }
+
+        ~cooperativeExecutor(){
+            for(int i = 0; i < tasks.size(); i++)
+                delete tasks[i].worker;
+        }
+
+        /**
+        * add a task after the ones already added (the order of the cycle)
+        * @param producers names of the tasks already added whose output the task reads blocking
+        * @param ownWorker the task blocks in its cycle, it runs in its own worker
+        */
+        void add(monitoredThread* thread, const std::string& name, const std::vector<std::string>& producers, bool ownWorker){
+            executorTask task;
+            task.thread = thread;
+            task.name = name;
+            for(int i = 0; i < producers.size(); i++){
+                int producer = find(producers[i]);
+                if(producer >= 0){
+                    task.producers.push_back(producer);
+                    task.producerTicks.push_back(0);
+                }
+            }
+            task.nextDue = 0;
+            task.worker = ownWorker ? new executorWorker(thread) : nullptr;
+            tasks.push_back(task);
+        }
+
+        int getNumberOfTasks(){
+            return tasks.size();
+        }
+
+        monitoredThread* getTask(int i){
+            return tasks[i].thread;
+        }
+
+        std::string getTaskName(int i){
+            return tasks[i].name;
+        }
+
+        int getNumberOfWorkers(){
+            int workers = 1;
+            for(int i = 0; i < tasks.size(); i++)
+                if(tasks[i].worker != nullptr)
+                    workers++;
+            return workers;
+        }
+
+        bool threadInit() override{
+            //in parallel: each task waits for its connections (connectionBarrier), the ports of the next ones must exist,
+            //the first that fails stops the waits of the others
+            std::vector<std::thread> inits;
+            std::vector<char> ok(tasks.size(), 0);
+            for(int i = 0; i < tasks.size(); i++)
+                inits.push_back(std::thread([this, &ok, i]{
+                    ok[i] = tasks[i].thread->initTask();
+                    if(!ok[i])
+                        connectionBarrier::abortAll();
+                }));
+            for(int i = 0; i < inits.size(); i++)
+                inits[i].join();
+
+            bool allOk = true;
+            for(int i = 0; i < tasks.size(); i++)
+                if(!ok[i]){
+                    yError("%s: initialization failed", tasks[i].name.c_str());
+                    allOk = false;
+                }
+            if(!allOk){
+                for(int i = tasks.size() - 1; i >= 0; i--)
+                    if(ok[i])
+                        tasks[i].thread->releaseTask();
+                return false;
+            }
+
+            for(int i = 0; i < tasks.size(); i++)
+                if(tasks[i].worker != nullptr && !tasks[i].worker->start()){
+                    yError("%s: unable to start the worker", tasks[i].name.c_str());
+                    for(int j = 0; j < i; j++)
+                        if(tasks[j].worker != nullptr)
+                            tasks[j].worker->stop();
+                    releaseTasks(tasks.size());
+                    return false;
+                }
+
+            followFastestTask();
+            initialized = true;
+            yInfo("Executor: %d tasks on %d workers, cycle %.3f s", (int)tasks.size(), getNumberOfWorkers(), getPeriod());
+            return true;
+        }
+
+        void run() override{
+            double cycleStart = yarp::os::Time::now();
+            double deadline = cycleStart + getPeriod();
+
+            for(int i = 0; i < tasks.size(); i++){
+                executorTask& task = tasks[i];
+                double now = yarp::os::Time::now();
+
+                if(task.worker != nullptr){
+                    if(!task.worker->isBusy() && isDue(task, now)){
+                        started(task, now);
+                        task.worker->trigger();
+                    }
+                    //the next tasks follow it in the order, but not beyond the cycle
+                    if(task.worker->isBusy())
+                        task.worker->waitIdle(deadline);
+                    continue;
+                }
+
+                if(!isDue(task, now))
+                    continue;
+                started(task, now);
+                task.thread->runTask();
+            }
+
+            followFastestTask();
+        }
+
+        void threadRelease() override{
+            if(!initialized)
+                return;
+            for(int i = 0; i < tasks.size(); i++)
+                if(tasks[i].worker != nullptr)
+                    tasks[i].worker->stop();
+            releaseTasks(tasks.size());
+            initialized = false;
+        }
+};
+
+#endif  //_COOPERATIVEEXECUTOR_H_
@@ -0,0 +1,229 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file csvParser.h
+ * @brief Parser of delimited lines (csv files and commands) shared by the modules.
+ *
+ * The fields are kept as positions in the current line (no copies), the numbers are converted in place
+ * with strtod/strtol and every error has the line and the column where it happened.
+ */
+
+#ifndef _CSVPARSER_H_
+#define _CSVPARSER_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cerrno>
+
+//Field of the current line: [begin, begin + length) of the line, column starting at 1
+typedef struct csvField_{
+    int begin;
+    int length;
+    int column;
+}csvField;
+
+class csvParser{
+    private:
+        std::ifstream file;
+        std::string source;     //filename, or the name given to parseLine
+        std::string line;
+        int lineNumber;
+        char delimiter;
+        std::vector<csvField> fields;
+        std::string error;      //first error since the last line parsed
+
+        void setError(int column, const std::string& message){
+            if(!error.empty())
+                return;
+            error = source + ":" + std::to_string(lineNumber) + ":" + std::to_string(column) + ": " + message;
+        }
+
+        //only spaces, tabs and carriage returns are trimmed
+        static bool isBlank(char c){
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        bool checkIndex(int i){
+            if(i >= 0 && i < fields.size())
+                return true;
+            setError(line.size() + 1, "missing field " + std::to_string(i + 1) + " (the line has " + std::to_string(fields.size()) + ")");
+            return false;
+        }
+
+    public:
+        csvParser(char delimiter_ = ','){
+            delimiter = delimiter_;
+            lineNumber = 0;
+        }
+
+        bool open(const std::string& filename){
+            file.close();
+            file.clear();
+            file.open(filename);
+            source = filename;
+            lineNumber = 0;
+            error.clear();
+            if(!file.is_open()){
+                error = "Couldn't open the " + filename + " file";
+                return false;
+            }
+            return true;
+        }
+
+        /**
+        * read and split the next line with data (empty lines are skipped)
+        * @return false at the end of the file
+        */
+        bool readLine(){
+            while(std::getline(file, line)){
+                lineNumber++;
+                split();
+                if(fields.size() > 0)
+                    return true;
+            }
+            return false;
+        }
+
+        /**
+        * split a line that does not come from a file (e.g. a command received in a port)
+        */
+        void parseLine(const std::string& text, const std::string& name = "command"){
+            source = name;
+            line = text;
+            lineNumber = 1;
+            split();
+        }
+
+        /**
+        * fields are trimmed, a delimiter at the end of the line does not add an empty field
+        */
+        void split(){
+            fields.clear();
+            error.clear();
+
+            int n = line.size();
+            while(n > 0 && isBlank(line[n - 1]))
+                n--;
+            if(n == 0)
+                return;
+
+            int start = 0;
+            while(true){
+                int end = start;
+                while(end < n && line[end] != delimiter)
+                    end++;
+
+                int b = start, e = end;
+                while(b < e && isBlank(line[b]))
+                    b++;
+                while(e > b && isBlank(line[e - 1]))
+                    e--;
+
+                csvField field;
+                field.begin = b;
+                field.length = e - b;
+                field.column = b + 1;
+                fields.push_back(field);
+
+                if(end == n)
+                    break;
+                start = end + 1;
+                if(start == n)  //delimiter at the end of the line
+                    break;
+            }
+        }
+
+        int size(){
+            return fields.size();
+        }
+
+        int getLineNumber(){
+            return lineNumber;
+        }
+
+        /**
+        * bounds-checked fixed schema: the line must have between minFields and maxFields fields
+        */
+        bool expectFields(int minFields, int maxFields){
+            if(fields.size() >= minFields && fields.size() <= maxFields)
+                return true;
+            setError(1, "expected " + std::to_string(minFields) + (maxFields == minFields ? "" : " to " + std::to_string(maxFields))
+                        + " fields, found " + std::to_string(fields.size()));
+            return false;
+        }
+
+        bool expectFields(int numberFields){
+            return expectFields(numberFields, numberFields);
+        }
+
+        std::string asString(int i){
+            if(!checkIndex(i))
+                return "";
+            return line.substr(fields[i].begin, fields[i].length);
+        }
+
+        /**
+        * the whole field must be a number, otherwise the error is set and 0 is returned
+        */
+        double asDouble(int i){
+            if(!checkIndex(i))
+                return 0.0;
+            const char* begin = line.c_str() + fields[i].begin;
+            char* end;
+            errno = 0;
+            double value = std::strtod(begin, &end);
+            if(fields[i].length == 0 || end != begin + fields[i].length || errno == ERANGE){
+                setError(fields[i].column, "'" + asString(i) + "' is not a number");
+                return 0.0;
+            }
+            return value;
+        }
+
+        int asInt(int i){
+            if(!checkIndex(i))
+                return 0;
+            const char* begin = line.c_str() + fields[i].begin;
+            char* end;
+            errno = 0;
+            long value = std::strtol(begin, &end, 10);
+            if(fields[i].length == 0 || end != begin + fields[i].length || errno == ERANGE || value != (int)value){
+                setError(fields[i].column, "'" + asString(i) + "' is not an integer");
+                return 0;
+            }
+            return value;
+        }
+
+        float asFloat(int i){
+            return asDouble(i);
+        }
+
+        /**
+        * true if there was no error since the last line parsed
+        */
+        bool ok(){
+            return error.empty();
+        }
+
+        std::string getError(){
+            return error;
+        }
+};
+
+#endif  //_CSVPARSER_H_
@@ -0,0 +1,52 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file iCubeTouch.h
+ * @brief Representation of the iCubes touch state shared by iCubeProcessor, perception and motivation.
+ */
+
+#ifndef _ICUBETOUCH_H_
+#define _ICUBETOUCH_H_
+
+#define NUMBER_OF_FACES 6
+
+//Status of each cube in the message
+#define ICUBE_OK         0
+#define NO_DATA         -1  //the cube is connected but did not send data in the step (different from receiving data with 0 faces touched)
+#define NO_CONNECTION   -2  //the cube is not connected
+
+//Layout of each cube in the iCubes message: (status touchMask pose)
+#define ICUBE_STATUS        0
+#define ICUBE_TOUCH_MASK    1   //bit i is 1 if the face i is being touched (0 if the status is not ICUBE_OK)
+#define ICUBE_POSE          2   //empty if there was no new movement in the step
+
+/**
+* number of faces touched in a touch mask
+*/
+inline int countTouchedFaces(unsigned int touchMask){
+    return __builtin_popcount(touchMask);
+}
+
+/**
+* 1 if the face is touched, 0 otherwise
+*/
+inline int isFaceTouched(unsigned int touchMask, int face){
+    return (touchMask >> face) & 1;
+}
+
+#endif  //_ICUBETOUCH_H_
@@ -0,0 +1,226 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file monitoredThread.h
+ * @brief Periodic thread of the modules: measures each cycle, reports the overruns and adapts the period within bounds.
+ *
+ * The modules implement tick() instead of run(). The period (and the bounds of the adaptation) come from the
+ * [periods] group of motivatedAutonomous.ini, the value given to the constructor is only the default.
+ */
+
+#ifndef _MONITOREDTHREAD_H_
+#define _MONITOREDTHREAD_H_
+
+#include <yarp/os/all.h>
+#include <yarp/os/PeriodicThread.h>
+#include <yarp/os/Log.h>
+#include <string>
+#include <mutex>
+#include <cmath>
+#include <algorithm>
+
+#define PERIOD_REPORT_INTERVAL  10.0    //s between two reports of the overruns
+
+//Cycles measured since the start
+typedef struct periodStats_{
+    double period;          //s, current (it changes with the adaptation)
+    unsigned int ticks;
+    unsigned int overruns;  //cycles that lasted more than the period
+    double meanUsed;        //s of execution of a cycle
+    double maxUsed;
+    double jitter;          //s, mean difference between the time from the previous cycle and the period
+}periodStats;
+
+class monitoredThread : public yarp::os::PeriodicThread {
+    private:
+        std::string threadName;
+        double nominalPeriod, minPeriod, maxPeriod;
+        bool cooperative;       //run by the cooperative executor (initTask) instead of its own thread
+
+        std::mutex statsMutex;
+        periodStats stats;
+        double sumUsed, sumJitter;
+        double lastStart;
+        double cycleStart;
+
+        //window of the report
+        unsigned int windowTicks, windowOverruns;
+        double windowMaxUsed;
+        double lastReport;
+
+        void record(double start, double used){
+            std::lock_guard<std::mutex> lock(statsMutex);
+            double period = getPeriod();
+            stats.period = period;
+            stats.ticks++;
+            sumUsed += used;
+            stats.meanUsed = sumUsed / stats.ticks;
+            stats.maxUsed = std::max(stats.maxUsed, used);
+            if(lastStart > 0){
+                sumJitter += std::fabs(start - lastStart - period);
+                stats.jitter = sumJitter / (stats.ticks - 1);
+            }
+            lastStart = start;
+
+            windowTicks++;
+            windowMaxUsed = std::max(windowMaxUsed, used);
+            if(used > period){
+                stats.overruns++;
+                windowOverruns++;
+            }
+
+            if(start - lastReport >= PERIOD_REPORT_INTERVAL){
+                if(windowOverruns > 0)
+                    yWarning("%s: %u of %u cycles over the period of %.3f s (max %.3f s, jitter %.3f s)", threadName.c_str(),
+                             windowOverruns, windowTicks, period, windowMaxUsed, stats.jitter);
+                windowTicks = 0;
+                windowOverruns = 0;
+                windowMaxUsed = 0;
+                lastReport = start;
+            }
+        }
+
+    protected:
+        /**
+        * one cycle of the module (the former run)
+        */
+        virtual void tick() = 0;
+
+        /**
+        * change the period, clamped to the bounds configured (no change if the adaptation is not enabled)
+        */
+        void requestPeriod(double period){
+            period = std::min(std::max(period, minPeriod), maxPeriod);
+            if(period != getPeriod())
+                setPeriod(period);
+        }
+
+        void requestFastPeriod(){
+            requestPeriod(minPeriod);
+        }
+
+        void requestSlowPeriod(){
+            requestPeriod(maxPeriod);
+        }
+
+        void requestNominalPeriod(){
+            requestPeriod(nominalPeriod);
+        }
+
+        /**
+        * the executor counts a tick as done when tick() returns, nothing of the cycle can be left running after it
+        */
+        bool isCooperative(){
+            return cooperative;
+        }
+
+        /**
+        * s until the end of the period of the cycle in progress (0 if it is already over)
+        */
+        double getTimeLeftInCycle(){
+            return std::max(cycleStart + getPeriod() - yarp::os::Time::now(), 0.0);
+        }
+
+    public:
+        monitoredThread(double period):PeriodicThread(period){
+            nominalPeriod = minPeriod = maxPeriod = period;
+            cooperative = false;
+            stats.period = period;
+            stats.ticks = 0;
+            stats.overruns = 0;
+            stats.meanUsed = 0;
+            stats.maxUsed = 0;
+            stats.jitter = 0;
+            sumUsed = 0;
+            sumJitter = 0;
+            lastStart = 0;
+            cycleStart = 0;
+            windowTicks = 0;
+            windowOverruns = 0;
+            windowMaxUsed = 0;
+            lastReport = 0;
+        }
+
+        /**
+        * period of the module from the line "module (period [min max])" of the [periods] group, without min and max the period is fixed
+        */
+        void configurePeriod(const yarp::os::Bottle& periods, const std::string& module){
+            threadName = module;
+            yarp::os::Bottle* values = periods.find(module).asList();
+            if(values == nullptr || values->size() < 1 || values->get(0).asFloat64() <= 0)
+                return;
+
+            nominalPeriod = minPeriod = maxPeriod = values->get(0).asFloat64();
+            if(values->size() >= 3){
+                minPeriod = std::min(values->get(1).asFloat64(), nominalPeriod);
+                maxPeriod = std::max(values->get(2).asFloat64(), nominalPeriod);
+            }
+            setPeriod(nominalPeriod);
+            yInfo("%s: period %.3f s (adaptive between %.3f and %.3f s)", module.c_str(), nominalPeriod, minPeriod, maxPeriod);
+        }
+
+        periodStats getPeriodStats(){
+            std::lock_guard<std::mutex> lock(statsMutex);
+            return stats;
+        }
+
+        /**
+        * reply of the "period" command of the modules: period ticks overruns meanUsed maxUsed jitter
+        */
+        void addPeriodStats(yarp::os::Bottle& reply){
+            periodStats current = getPeriodStats();
+            reply.addFloat64(current.period);
+            reply.addInt32(current.ticks);
+            reply.addInt32(current.overruns);
+            reply.addFloat64(current.meanUsed);
+            reply.addFloat64(current.maxUsed);
+            reply.addFloat64(current.jitter);
+        }
+
+        /**
+        * period configured, the adaptation changes the current one around it
+        */
+        double getNominalPeriod(){
+            return nominalPeriod;
+        }
+
+        void run() override{
+            double start = yarp::os::Time::now();
+            cycleStart = start;
+            tick();
+            record(start, yarp::os::Time::now() - start);
+        }
+
+        /**
+        * init, cycle and release called by the cooperative executor instead of the own thread (see cooperativeExecutor.h)
+        */
+        bool initTask(){
+            cooperative = true;
+            return threadInit();
+        }
+
+        void runTask(){
+            run();
+        }
+
+        void releaseTask(){
+            threadRelease();
+        }
+};
+
+#endif  //_MONITOREDTHREAD_H_
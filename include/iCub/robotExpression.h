@@ -0,0 +1,287 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file robotExpression.h
+ * @brief Face LEDs, eyelids and movements of the robot shared by the action and sleeping modules.
+ *
+ * The LED codes and eyelid poses are tables indexed by the expression and the platform, and the
+ * commands are built once (the names received in the commands are translated only when they arrive).
+ */
+
+#ifndef _ROBOTEXPRESSION_H_
+#define _ROBOTEXPRESSION_H_
+
+#include <yarp/os/all.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <algorithm>
+
+#define REDDY_ROBOT     "reddy"
+#define BERRY_ROBOT     "berry"
+
+enum robotPlatformType { PLATFORM_OTHER, PLATFORM_BERRY, PLATFORM_REDDY, NUMBER_OF_PLATFORMS };
+enum eyebrowExpression { EYEBROW_NONE, EYEBROW_RAISE, EYEBROW_LOWER, EYEBROW_NEUTRAL, EYEBROW_EVIL, EYEBROW_CUNNY, NUMBER_OF_EYEBROWS };
+enum mouthExpression { MOUTH_NONE, MOUTH_SMILE, MOUTH_FROWN, MOUTH_OPEN, MOUTH_SAD, MOUTH_NEUTRAL, MOUTH_EVIL, MOUTH_CUNNY, NUMBER_OF_MOUTHS };
+enum eyelidsMovement { EYELIDS_CLOSE, EYELIDS_OPEN, NUMBER_OF_EYELIDS_MOVEMENTS };
+enum movementBodyPart { BODY_RIGHT_ARM, BODY_LEFT_ARM, BODY_TORSO, NUMBER_OF_BODY_PARTS, BODY_NONE };
+
+//Names used in the commands and LED codes of the face controller (empty: nothing is sent)
+static const char* const EYEBROW_NAMES[NUMBER_OF_EYEBROWS]      = {"",   "raise", "lower", "neutral", "evil", "cunny"};
+static const char* const EYEBROW_LEFT_LEDS[NUMBER_OF_EYEBROWS]  = {"",   "L01",   "L04",   "L02",     "L05",  "L07"};
+static const char* const EYEBROW_RIGHT_LEDS[NUMBER_OF_EYEBROWS] = {"",   "R01",   "R04",   "R02",     "R05",  "R07"};
+static const char* const MOUTH_NAMES[NUMBER_OF_MOUTHS]          = {"",   "smile", "frown", "open", "sad", "neutral", "evil", "cunny"};
+static const char* const MOUTH_LEDS[NUMBER_OF_MOUTHS]           = {"",   "M01",   "M02",   "M03",  "M02", "M00",     "M05",  "M07"};
+
+//Eyelids pose of each platform: emotionInterface raw code (Reddy) and ctpService position (Berry)
+static const char* const REDDY_EYELIDS_POSE[NUMBER_OF_EYELIDS_MOVEMENTS] = {"S64", "S01"};
+static const int BERRY_EYELIDS_POSE[NUMBER_OF_EYELIDS_MOVEMENTS]         = {64, 1};
+
+static const char* const BODY_PART_NAMES[NUMBER_OF_BODY_PARTS] = {"rightArm", "leftArm", "torso"};
+
+inline int findName(const char* const names[], int size, const std::string& name){
+    for(int i = 0; i < size; i++)
+        if(name == names[i])
+            return i;
+    return -1;
+}
+
+inline int platformFromName(const std::string& robotPlatform){
+    if(robotPlatform == BERRY_ROBOT)
+        return PLATFORM_BERRY;
+    if(robotPlatform == REDDY_ROBOT)
+        return PLATFORM_REDDY;
+    return PLATFORM_OTHER;
+}
+
+inline int eyebrowFromName(const std::string& name){
+    int index = findName(EYEBROW_NAMES, NUMBER_OF_EYEBROWS, name);
+    return index < 0 ? EYEBROW_NONE : index;
+}
+
+inline int mouthFromName(const std::string& name){
+    int index = findName(MOUTH_NAMES, NUMBER_OF_MOUTHS, name);
+    return index < 0 ? MOUTH_NONE : index;
+}
+
+inline int eyelidsFromName(const std::string& name){
+    return name == "open" ? EYELIDS_OPEN : EYELIDS_CLOSE;
+}
+
+//One step of a movement of the movement group: joint positions and body part (BODY_NONE: the one given when executing)
+typedef struct movementStep_{
+    yarp::os::Bottle positions;
+    int bodyPart;
+}movementStep;
+
+class robotExpression{
+    private:
+        int platform;
+
+        //commands built once
+        yarp::os::Bottle eyebrowLeftCommands[NUMBER_OF_EYEBROWS];
+        yarp::os::Bottle eyebrowRightCommands[NUMBER_OF_EYEBROWS];
+        yarp::os::Bottle mouthCommands[NUMBER_OF_MOUTHS];
+        yarp::os::Bottle reddyEyelidsCommands[NUMBER_OF_EYELIDS_MOVEMENTS];
+        yarp::os::Bottle berryEyelidsPoses[NUMBER_OF_EYELIDS_MOVEMENTS];
+
+        //movements of the movement group, read from the configuration the first time they are executed
+        std::map<std::string, std::vector<movementStep> > movements;
+
+        yarp::os::Port emotionsPort;                                    //facial LED controller
+        yarp::os::RpcClient movementPorts[NUMBER_OF_BODY_PARTS];        //ctpService of each body part
+        yarp::os::RpcClient eyelidsPort;                                //ctpService (Berry) or emotionInterface (Reddy)
+
+        const std::vector<movementStep>& getMovement(yarp::os::ResourceFinder& rf, const std::string& movement){
+            std::map<std::string, std::vector<movementStep> >::iterator found = movements.find(movement);
+            if(found != movements.end())
+                return found->second;
+
+            yarp::os::Bottle& movementGroup = rf.findGroup("movement");
+            yarp::os::Bottle listOfJointPos = movementGroup.findGroup(movement).findGroup("seq").tail();
+            yarp::os::Bottle bodyPartNew = movementGroup.findGroup(movement).findGroup("bodyPart").tail();
+
+            std::vector<movementStep>& steps = movements[movement];
+            for(int i = 0; i < listOfJointPos.size(); i++){
+                movementStep step;
+                step.positions = movementGroup.findGroup(listOfJointPos.get(i).asString()).tail();
+                std::string bodyPart = bodyPartNew.get(i).asString();
+                step.bodyPart = bodyPart == "input" ? BODY_NONE : findName(BODY_PART_NAMES, NUMBER_OF_BODY_PARTS, bodyPart);
+                steps.push_back(step);
+            }
+            return steps;
+        }
+
+    public:
+        robotExpression(){
+            platform = PLATFORM_OTHER;
+
+            for(int i = 0; i < NUMBER_OF_EYEBROWS; i++){
+                eyebrowLeftCommands[i].fromString(EYEBROW_LEFT_LEDS[i]);
+                eyebrowRightCommands[i].fromString(EYEBROW_RIGHT_LEDS[i]);
+            }
+            for(int i = 0; i < NUMBER_OF_MOUTHS; i++)
+                mouthCommands[i].fromString(MOUTH_LEDS[i]);
+
+            for(int i = 0; i < NUMBER_OF_EYELIDS_MOVEMENTS; i++){
+                reddyEyelidsCommands[i].addVocab32("set");
+                reddyEyelidsCommands[i].addVocab32("raw");
+                reddyEyelidsCommands[i].addVocab32(yarp::os::Vocab32::encode(REDDY_EYELIDS_POSE[i]));
+                berryEyelidsPoses[i].addInt16(BERRY_EYELIDS_POSE[i]);
+            }
+        }
+
+        /**
+        * open the ports of the face, eyelids and movements
+        * @param name root name of the ports of the module
+        */
+        bool openPorts(const std::string& name, const std::string& robotPlatform){
+            platform = platformFromName(robotPlatform);
+
+            if(!emotionsPort.open(name + "/cmdFace:rpc")){
+                yError("unable to open port to send emotions LED");
+                return false;
+            }
+
+            const char* const movementPortNames[NUMBER_OF_BODY_PARTS] = {"/movement/right_arm", "/movement/left_arm", "/movement/torso"};
+            for(int i = 0; i < NUMBER_OF_BODY_PARTS; i++){
+                movementPorts[i].setRpcMode(true);
+                if(!movementPorts[i].open(name + movementPortNames[i])){
+                    yError("unable to open port to send %s commands", BODY_PART_NAMES[i]);
+                    return false;
+                }
+            }
+
+            if(platform == PLATFORM_BERRY || platform == PLATFORM_REDDY){
+                eyelidsPort.setRpcMode(true);
+                if(!eyelidsPort.open(name + (platform == PLATFORM_BERRY ? "/movement/face" : "/emotions/out"))){
+                    yError("unable to open port for eyelids control");
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+        * true when all the ports needed by the platform are connected
+        */
+        bool isConnected(){
+            if(platform != PLATFORM_OTHER && (emotionsPort.getOutputCount() < 1 || eyelidsPort.getOutputCount() < 1))
+                return false;
+            for(int i = 0; i < NUMBER_OF_BODY_PARTS; i++)
+                if(movementPorts[i].getOutputCount() < 1)
+                    return false;
+            return true;
+        }
+
+        void setFace(int eyebrow, int mouth){
+            if(!emotionsPort.getOutputCount())
+                return;
+            if(eyebrow != EYEBROW_NONE){
+                emotionsPort.write(eyebrowLeftCommands[eyebrow]);
+                emotionsPort.write(eyebrowRightCommands[eyebrow]);
+            }
+            if(mouth != MOUTH_NONE)
+                emotionsPort.write(mouthCommands[mouth]);
+        }
+
+        /**
+        * @return s until the eyelids stop (the reply of the emotionInterface of Reddy arrives when they are done)
+        */
+        double moveEyelids(double time, double offset, int movement){
+            yarp::os::Bottle response;
+            if(platform == PLATFORM_REDDY){
+                std::cout<<reddyEyelidsCommands[movement].toString()<<std::endl;
+                eyelidsPort.write(reddyEyelidsCommands[movement], response);
+            }else if(platform == PLATFORM_BERRY){
+                yarp::os::Bottle cmd;
+                cmd.addVocab32("ctpq");
+                cmd.addVocab32("time");
+                cmd.addFloat64(time);
+                cmd.addVocab32("off");
+                cmd.addFloat64(offset);
+                cmd.addVocab32("pos");
+                cmd.addList() = berryEyelidsPoses[movement];
+
+                std::cout<<cmd.toString()<<std::endl;
+                eyelidsPort.write(cmd, response);
+                return offset + time;
+            }
+            return 0.0;
+        }
+
+        /**
+        * send the joint positions of each step of a movement of the movement group to the ctpService of its body part
+        * @param bodyPart used by the steps whose body part is "input"
+        * @param cancel the steps not sent yet are dropped when it becomes true
+        * @return s until the last step sent ends (ctpService queues the steps of each body part and replies at once)
+        */
+        double executeMovement(yarp::os::ResourceFinder& rf, double time, double offset, const std::string& bodyPart, const std::string& movement, const std::atomic<bool>* cancel = nullptr){
+            const std::vector<movementStep>& steps = getMovement(rf, movement);
+            int inputBodyPart = findName(BODY_PART_NAMES, NUMBER_OF_BODY_PARTS, bodyPart);
+            double partTime[NUMBER_OF_BODY_PARTS] = {0.0};
+            double duration = 0.0;
+
+            for(int i = 0; i < steps.size(); i++){
+                if(cancel != nullptr && *cancel)
+                    return duration;
+                int part = steps[i].bodyPart == BODY_NONE ? inputBodyPart : steps[i].bodyPart;
+                if(part < 0 || !movementPorts[part].getOutputCount())
+                    continue;
+
+                yarp::os::Bottle cmd;
+                cmd.addVocab32("ctpq");
+                cmd.addVocab32("time");
+                cmd.addFloat64(time);
+                cmd.addVocab32("off");
+                cmd.addFloat64(offset);
+                cmd.addVocab32("pos");
+                cmd.addList() = steps[i].positions;
+
+                std::cout<<BODY_PART_NAMES[part]<<std::endl;
+                yarp::os::Bottle response;
+                movementPorts[part].write(cmd, response);
+
+                partTime[part] += offset + time;
+                duration = std::max(duration, partTime[part]);
+            }
+            return duration;
+        }
+
+        int getMovementSteps(yarp::os::ResourceFinder& rf, const std::string& movement){
+            return getMovement(rf, movement).size();
+        }
+
+        void interrupt(){
+            emotionsPort.interrupt();
+            eyelidsPort.interrupt();
+            for(int i = 0; i < NUMBER_OF_BODY_PARTS; i++)
+                movementPorts[i].interrupt();
+        }
+
+        void close(){
+            emotionsPort.close();
+            eyelidsPort.close();
+            for(int i = 0; i < NUMBER_OF_BODY_PARTS; i++)
+                movementPorts[i].close();
+        }
+};
+
+#endif  //_ROBOTEXPRESSION_H_
@@ -0,0 +1,99 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file skinTouch.h
+ * @brief Body part touched in the events of the skinProcessorHelper, shared by perception and the touch reflex of action.
+ */
+
+#ifndef _SKINTOUCH_H_
+#define _SKINTOUCH_H_
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <boost/algorithm/string.hpp>
+
+//Part touched, same order of the bodyPart enum of perception and decision making
+#define SKIN_TORSO          0
+#define SKIN_LEFT_HAND      1
+#define SKIN_LEFT_FOREARM   2
+#define SKIN_LEFT_UPPER     3
+#define SKIN_RIGHT_HAND     4
+#define SKIN_RIGHT_FOREARM  5
+#define SKIN_RIGHT_UPPER    6
+#define SKIN_NO_TOUCH       7
+#define NUMBER_OF_SKIN_PARTS 7
+
+//Side touched, same order of the bodySide enum
+#define SKIN_SIDE_TORSO     0
+#define SKIN_SIDE_LEFT      1
+#define SKIN_SIDE_RIGHT     2
+#define SKIN_SIDE_NO_TOUCH  3
+
+#define SKIN_MIN_PRESSURE   5.0
+#define SKIN_MIN_TAXELS     7.0
+
+//false if the field is not a number (std::stod throws)
+inline bool parseSkinValue(const std::string& field, double& value){
+    char* end = nullptr;
+    value = std::strtod(field.c_str(), &end);
+    return !field.empty() && end == field.c_str() + field.size();
+}
+
+/**
+* body part and side of a skin event "(part) pressure taxels"
+* @return false if it is not a touch (too weak or without the origin)
+*/
+inline bool parseSkinTouch(const std::string& skinInput, int& origin, int& side){
+    origin = SKIN_NO_TOUCH;
+    side = SKIN_SIDE_NO_TOUCH;
+
+    std::vector<std::string> fields;
+    boost::split(fields, skinInput, boost::is_any_of(" "), boost::token_compress_on);
+
+    //fields.size() == 3 to avoid cases when the robot "feels" a touch that doesnt exist (has the value but not the origin)
+    double pressure, taxels;
+    if(fields.size() != 3 || fields[0].size() < 3 || !parseSkinValue(fields[1], pressure) || !parseSkinValue(fields[2], taxels))
+        return false;
+    if(pressure <= SKIN_MIN_PRESSURE || taxels <= SKIN_MIN_TAXELS)
+        return false;
+
+    if(fields[0][1] == 't'){//torso
+        side = SKIN_SIDE_TORSO;
+        origin = SKIN_TORSO;
+    }else if(fields[0][1] == 'l'){//left arm
+        side = SKIN_SIDE_LEFT;
+        if(fields[0][2] == 'h')//hand
+            origin = SKIN_LEFT_HAND;
+        else if(fields[0][2] == 'f')//forearm
+            origin = SKIN_LEFT_FOREARM;
+        else
+            origin = SKIN_LEFT_UPPER;//upper arm
+    }else if(fields[0][1] == 'r'){//right arm
+        side = SKIN_SIDE_RIGHT;
+        if(fields[0][2] == 'h')//hand
+            origin = SKIN_RIGHT_HAND;
+        else if(fields[0][2] == 'f')//forearm
+            origin = SKIN_RIGHT_FOREARM;
+        else
+            origin = SKIN_RIGHT_UPPER;//upper arm
+    }
+    return true;
+}
+
+#endif  //_SKINTOUCH_H_
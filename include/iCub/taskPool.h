@@ -0,0 +1,132 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file taskPool.h
+ * @brief Small pool of worker threads sharing one queue of tasks.
+ *
+ * The thread that waits for the tasks runs the ones not taken yet instead of sleeping, so a pool of n workers
+ * uses n + 1 threads and a pool of 0 workers runs everything in the caller, in the order posted.
+ */
+
+#ifndef _TASKPOOL_H_
+#define _TASKPOOL_H_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class taskPool{
+    private:
+        std::vector<std::thread> workers;
+        std::mutex poolMutex;
+        std::condition_variable taskPosted;
+        std::condition_variable tasksDone;
+        std::deque<std::function<void()>> queue;
+        int unfinished;                             //posted and not ended yet
+        bool stopping;
+
+        bool take(std::function<void()>& task){
+            if(queue.empty())
+                return false;
+            task = std::move(queue.front());
+            queue.pop_front();
+            return true;
+        }
+
+        void done(){
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if(--unfinished == 0)
+                tasksDone.notify_all();
+        }
+
+        void work(){
+            while(true){
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(poolMutex);
+                    taskPosted.wait(lock, [this]{ return stopping || !queue.empty(); });
+                    if(!take(task))
+                        return;
+                }
+                task();
+                done();
+            }
+        }
+
+    public:
+        taskPool(){
+            unfinished = 0;
+            stopping = false;
+        }
+
+        ~taskPool(){
+            stop();
+        }
+
+        void start(int numberOfWorkers){
+            stopping = false;
+            for(int i = 0; i < numberOfWorkers; i++)
+                workers.push_back(std::thread(&taskPool::work, this));
+        }
+
+        /**
+        * the tasks already posted are done before the workers quit
+        */
+        void stop(){
+            {
+                std::lock_guard<std::mutex> lock(poolMutex);
+                stopping = true;
+                taskPosted.notify_all();
+            }
+            for(int i = 0; i < workers.size(); i++)
+                workers[i].join();
+            workers.clear();
+            wait();
+        }
+
+        int getNumberOfWorkers(){
+            return workers.size();
+        }
+
+        void post(std::function<void()> task){
+            std::lock_guard<std::mutex> lock(poolMutex);
+            queue.push_back(std::move(task));
+            unfinished++;
+            taskPosted.notify_one();
+        }
+
+        /**
+        * run the tasks not taken by the workers, then wait for the ones they are running
+        */
+        void wait(){
+            std::unique_lock<std::mutex> lock(poolMutex);
+            std::function<void()> task;
+            while(take(task)){
+                lock.unlock();
+                task();
+                done();
+                lock.lock();
+            }
+            tasksDone.wait(lock, [this]{ return unfinished == 0; });
+        }
+};
+
+#endif  //_TASKPOOL_H_
@@ -0,0 +1,113 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file actionChannel.h
+ * @brief Queues of the commands of the action module, one channel for each priority.
+ */
+
+#ifndef _ACTIONCHANNEL_H_
+#define _ACTIONCHANNEL_H_
+
+#include <yarp/os/all.h>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "iCub/csvParser.h"
+
+//Priority of the commands (lower value, higher priority), one channel for each
+//a stop preempts the work of the channels from PRIORITY_PREEMPTABLE on (the eyelids and the face are quick state changes)
+#define PRIORITY_SAFETY         0   //stop, powerOff, recharge
+#define PRIORITY_FACE           1   //eyelids and face LEDs
+#define PRIORITY_GAZE           2
+#define PRIORITY_PREEMPTABLE    PRIORITY_GAZE
+#define PRIORITY_SPEECH         3   //speech (blocks its channel until the sentence ends)
+#define PRIORITY_GESTURE        4   //movements of the arms and torso, ARE
+#define NUMBER_OF_PRIORITIES    5
+
+//Gaze commands in the queue: a new GAZE_TARGET replaces all the gaze commands not executed yet
+#define NOT_GAZE        0
+#define GAZE_RELATIVE   1   //turnHeadAngle, turnHeadTwoAngles, lookAround
+#define GAZE_TARGET     2   //moveHeadDirection, lookAtPoint
+
+//Result of a command, published in the completion event
+#define COMMAND_DONE        0   //the actuator finished the motion, sentence or request
+#define COMMAND_SKIPPED     1   //dropped because the actuator was already in that state or it was replaced
+#define COMMAND_FAILED      2   //malformed
+#define COMMAND_PREEMPTED   3   //removed from the queue or interrupted by a stop
+#define NUMBER_OF_RESULTS   4
+
+//name of a result in the completion event
+inline const char* commandResultName(int result){
+    static const char* names[NUMBER_OF_RESULTS] = {"done", "skipped", "failed", "preempted"};
+    return result >= 0 && result < NUMBER_OF_RESULTS ? names[result] : "unknown";
+}
+
+#define NO_COMMAND_ID       -1  //command sent without id, its completion is still published
+
+typedef struct queuedCommand_{
+    std::string text;
+    int gazeType;
+    int id;
+}queuedCommand;
+
+class actionThread;
+
+/*  Queue of the commands of one actuator channel, executed in order by its own thread
+    (the channels run concurrently, so a command never waits behind the commands of other actuators)
+*/
+class actionChannel : public yarp::os::Thread {
+    private:
+        actionThread* owner;
+        int priority;
+        double minInterval;             //s between the start of two commands (0: as soon as the previous ends)
+
+        std::mutex queueMutex;
+        std::condition_variable queueChanged;
+        std::deque<queuedCommand> queue;
+        std::atomic<bool> preempted;    //the command in execution must stop as soon as possible
+
+        csvParser parser;               //fields of the command in execution
+
+    public:
+        actionChannel(actionThread* owner_, int priority_, double minInterval_);
+
+        void push(const queuedCommand& command);
+
+        /**
+        * drop the commands queued and ask the one in execution to stop
+        */
+        void preempt();
+        bool isPreempted();
+        const std::atomic<bool>* getPreemptedFlag();
+
+        csvParser& getParser();
+        int getPriority();
+
+        /**
+        * true if the command in execution must stop waiting for its actuator (preempted or shutting down)
+        */
+        bool isCancelled();
+
+        void run() override;
+        void onStop() override;
+};
+
+#endif  //_ACTIONCHANNEL_H_
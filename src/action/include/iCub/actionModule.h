@@ -51,7 +51,7 @@ class actionModule:public yarp::os::RFModule {
 
     std::string robotPlatform;
     /*  */
-    actionThread *pThread;             // pointer to a new thread to be created and started in configure() and stopped in close()
+    actionThread *pThread = nullptr; // pointer to a new thread to be created and started in configure() and stopped in close()
 
 public:
     /**
@@ -35,14 +35,50 @@
 #include <fstream>
 #include <ctime>
 #include <cstring>
+#include <cmath>
 #include <boost/algorithm/string.hpp>
 #include <string.h>
+#include <deque>
+#include <mutex>
+
+#include "iCub/csvParser.h"
+#include "iCub/robotExpression.h"
+#include "iCub/actionChannel.h"
+#include "iCub/areClient.h"
+#include "iCub/gazeController.h"
+#include "iCub/skinTouch.h"
+#include "iCub/connectionBarrier.h"
+#include "iCub/monitoredThread.h"
 
-#define REDDY_ROBOT     "reddy"
-#define BERRY_ROBOT     "berry"
 #define ICUBSIM_ROBOT   "icubSim"
 
-class actionThread : public yarp::os::PeriodicThread {
+//Completion of the commands
+#define DONE_POLL_PERIOD        0.05    //s between two checks of the actuator
+#define GAZE_DONE_TIMEOUT       5.0     //s, the gaze is considered done after it
+#define SPEECH_DONE_TIMEOUT     30.0
+#define SPEECH_TIME_NO_STATUS   3.0     //s of a sentence when the speech module does not give its status
+#define SPEECH_MIN_INTERVAL     0.5     //s between the start of two sentences (SPEECH_MIN_INTERVAL of the variables group)
+
+//Trajectory times of the gaze (ARE changes them)
+#define EYES_TRAJ_TIME          0.7     //0.5 pilot, 0.2 orig, 0.7
+#define NECK_TRAJ_TIME          0.9     //0.9 pilot, 0.8 orig, 0.9
+
+class actionThread;
+
+/*  Skin events of the skinProcessorHelper, handled as soon as they arrive by the touch reflex
+*/
+class touchReflexPort : public yarp::os::BufferedPort<yarp::os::Bottle>{
+    private:
+        actionThread* thread;
+    public:
+        touchReflexPort();
+        void setThread(actionThread* thread_);
+
+        using yarp::os::BufferedPort<yarp::os::Bottle>::onRead;
+        void onRead(yarp::os::Bottle& skin) override;
+};
+
+class actionThread : public monitoredThread {
 private:
 
     std::string robot;              // name of the robot
@@ -73,28 +109,43 @@ private:
     int middleX_leftCam, middleY_leftCam, middleX_rightCam, middleY_rightCam;
     double z = 1.0;   // distance [m] of the object from the image plane (extended to infinity): yes, you probably need to guess, but it works pretty robustly
 
-    time_t now;
-    std::string timeNow;
     std::time_t timeInitial;
-    int turnFlag;
-    std::time_t timePastIdle;
 
     yarp::os::BufferedPort<yarp::os::Bottle> inputCommandSMPort;
+    actionChannel* channels[NUMBER_OF_PRIORITIES];    //one for each priority, each one with its own thread
+
+    std::mutex gazeMutex;               //iGaze is used by the gaze channel and after ARE (gesture channel)
+    std::mutex dataMutex;               //csv files written by all the channels
+    std::mutex doneMutex;               //completion events published by all the channels
+
+    yarp::os::BufferedPort<yarp::os::Bottle> outputDonePort;
+    yarp::os::RpcClient speechStatusPort;
+
+    //state of the actuators, to drop the commands that would not change it (-1 or "" if unknown)
+    int currentEyebrow;
+    int currentMouth;
+    std::atomic<int> currentEyelids;    //written by the face channel, also read by the touch reflex callback
+    std::string currentPose;            //last movement with only one step executed, "" after any other movement of the arms
+
+    //touch reflex: look at the part touched without waiting for decision making, which is told after it
+    bool reflexEnabled;
+    std::string reflexTargets[NUMBER_OF_SKIN_PARTS];    //gaze target of each part
+    double reflexHold;                  //s looking at the part
+    double reflexRefractory;            //s after a reflex without another one
+    double reflexAfterGaze;             //s after a gaze command of decision making without reflexes
+    double lastReflex;
+    std::atomic<double> lastGazeCommand;
+    touchReflexPort inputTouchReflexPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> outputReflexPort;  //part target
    
-    yarp::os::Port outputPortObjectToActAt;
+    areClient are;                      //requests to ARE sent by its own thread
+    gazeController gaze;                //targets, turns, look around and face tracking streamed to iGaze by its own thread
+    std::atomic<bool> gazeSpeedStale;   //ARE was used, its gaze speed may be different (set and checked with gazeMutex taken)
     yarp::os::BufferedPort<yarp::os::Bottle> outputPortRecharge;
 
     yarp::os::BufferedPort<yarp::os::Bottle> outputSpeechPort;
 
-    yarp::os::Port outputEmotionsPort;
-
-    yarp::os::RpcClient outputMovementRAPort;
-    yarp::os::RpcClient outputMovementLAPort; 
-    yarp::os::RpcClient outputMovementTPort;
-
-
-    yarp::os::RpcClient outRpcEyelids_berry;  // RPC port to control the eyelids -- Berry
-    yarp::os::RpcClient outRpcEyelids_reddy;  // RPC port to control the eyelids -- Reddy
+    robotExpression expression;     //face LEDs, eyelids (Berry, Reddy) and movements of the arms and torso
     yarp::os::BufferedPort<yarp::os::Bottle> outputPortEyelids_icub;  // RPC port to control the eyelids -- iCubSim
 
 public:
@@ -129,7 +180,7 @@ public:
     /**
     *  active part of the thread
     */
-    void run(); 
+    void tick() override;
 
     /**
     * function that sets the rootname of all the ports that are going to be created by the thread
@@ -163,15 +214,23 @@ public:
     void saveHeaders();
 
     void readCommandSM();
+    void queueCommand(const std::string& commandData, int id);
+
+    /**
+    * drop the work of the gaze, speech and gesture channels and stop the gaze (command stop)
+    */
+    void stopLowerPriorities();
+
+    int getPriority(const std::string& actionType);
+    bool commandOk(csvParser& commandParser);   //false (and the error printed) if the fields of the command could not be parsed
+    std::string getTimeNow();
 
     void actARE(std::string actionARE, int pXL, int pYL, int pXR, int pYR);
     void computeTargetCentroid(int topXLeft, int topYLeft, int bottomXLeft, int bottomYLeft, int topXRight, int topYRight, int bottomXRight, int bottomYRight);
-    void writeToARE();
+    void writeToARE(actionChannel& channel);
     void homeARE();
 
     void moveHeadDirection(std::string direction);
-    void executeMovement(const double time, const double offset, const std::string bodyPart, const std::string movement);
-    void setFaceModular(std::string affectEyebr, std::string affectMouth);
     void speakText(std::string speech);
 
     void turnHeadAngle(float angle);
@@ -181,10 +240,31 @@ public:
     void lookAtPointMono(int pointX, int pointY, int camera);
     void lookAtPointStereo(int pointX_Left, int pointY_Left, int pointX_Right, int pointY_Right);
 
+    bool configureReflex(const yarp::os::Bottle& variables);
+    void touchReflex(const std::string& skinInput);
+
     void changeIGazeSpeed();
+    void restoreIGazeSpeed();           //with gazeMutex locked
+
+    double moveEyelids(const double time, const double offset, std::string movement);
+
+    /**
+    * execute a command in the thread of its channel, it returns when the actuator has finished
+    * @return COMMAND_DONE, COMMAND_SKIPPED (already done), COMMAND_FAILED (malformed) or COMMAND_PREEMPTED
+    */
+    int executeCommand(const std::string& commandData, actionChannel& channel);
 
-    void moveEyelids(const double time, const double offset, std::string movement);
-    yarp::os::Bottle getEyelidsPose(std::string movement);
+    /**
+    * wait for the actuator, returning earlier if the channel is preempted
+    */
+    void waitFor(double duration, actionChannel& channel);
+    void waitGazeDone(actionChannel& channel);
+    void waitSpeechDone(actionChannel& channel);
+
+    /**
+    * publish the completion event of a command: id result command
+    */
+    void commandDone(const queuedCommand& command, int result);
     yarp::os::Bottle updateStatusEyelids_ToPerception(std::string movement);
 };
 
@@ -0,0 +1,74 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file areClient.h
+ * @brief Asynchronous RPC client of the actionsRenderingEngine.
+ */
+
+#ifndef _ARECLIENT_H_
+#define _ARECLIENT_H_
+
+#include <yarp/os/all.h>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <memory>
+
+typedef struct areRequest_{
+    yarp::os::Bottle command;
+    std::shared_ptr<std::promise<yarp::os::Bottle>> reply;
+}areRequest;
+
+/*  RPC client of the actionsRenderingEngine: the requests are sent in order by its own thread
+    and the caller gets a future with the reply, so it can wait for it or give up without blocking the port
+*/
+class areClient : public yarp::os::Thread {
+    private:
+        yarp::os::Port port;
+
+        std::mutex requestsMutex;
+        std::condition_variable requestsChanged;
+        std::deque<areRequest> requests;
+        bool busy;                          //a request is waiting for its reply
+
+    public:
+        areClient();
+
+        bool open(const std::string& name);
+        int getOutputCount();
+
+        /**
+        * queue a request (point, home...), the future gets the reply of ARE (empty if it could not be sent)
+        */
+        std::future<yarp::os::Bottle> send(const yarp::os::Bottle& command);
+
+        /**
+        * true while there are requests queued or waiting for their reply
+        */
+        bool isBusy();
+
+        void run() override;
+        void onStop() override;
+
+        void interrupt();
+        void close();
+};
+
+#endif  //_ARECLIENT_H_
@@ -0,0 +1,121 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file gazeController.h
+ * @brief Smooth pursuit of the gaze: fixation, scan, face tracking and reflexes streamed to iGaze.
+ */
+
+#ifndef _GAZECONTROLLER_H_
+#define _GAZECONTROLLER_H_
+
+#include <yarp/os/all.h>
+#include <yarp/dev/all.h>
+#include <yarp/sig/all.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <random>
+
+//Modes of the gaze
+#define GAZE_MODE_IDLE      0   //iGaze driven directly (pixels, ARE)
+#define GAZE_MODE_FIXATE    1   //smooth pursuit to a target of the table or a relative turn
+#define GAZE_MODE_SCAN      2   //look around: the targets of GAZE_SCAN in order, each for a random dwell time
+#define GAZE_MODE_TRACK     3   //follow the face seen by the perception
+#define GAZE_MODE_REFLEX    4   //look at a target for a while, then back to the previous mode
+
+#define GAZE_DEFAULT_PERIOD         0.05    //s between two setpoints sent to iGaze
+#define GAZE_DEFAULT_SPEED          40.0    //deg/s of the pursuit
+#define GAZE_TRACK_TIMEOUT          2.0     //s without a face before going back to the last target
+
+//Azimuth (horizontal) and elevation (vertical) in deg, vergence is kept at 0
+typedef struct gazeTarget_{
+    double azimuth;
+    double elevation;
+}gazeTarget;
+
+/*  Streams the gaze setpoints to iGaze at a higher rate than the action thread: the commands only change the
+    goal (a named target loaded at start, a turn, a scan or the face) and the thread moves the setpoint towards it
+*/
+class gazeController : public yarp::os::PeriodicThread {
+    private:
+        yarp::dev::IGazeControl* iGaze;
+        std::mutex* gazeMutex;                      //shared with the action thread, also guards the state below
+
+        std::map<std::string, gazeTarget> targets;
+        std::vector<std::string> scanTargets;
+        double speed;
+        double minDwell, maxDwell;
+        double faceDistance;                        //m of the face from the image plane, guessed like in the action thread
+
+        int mode;
+        gazeTarget setpoint, goal;
+        double lastRun;
+        int scanIndex;
+        double nextScan;
+        double lastFace;
+        bool settled;
+
+        int resumeMode;                             //mode and goal before the reflex
+        gazeTarget resumeGoal;
+        double reflexEnd;
+
+        std::mt19937 rng;
+
+        yarp::os::BufferedPort<yarp::os::Bottle> inputFacePort;   //affect focusX focusY faceSeen of the perception
+
+        void startFromCurrentAngles();
+        void sendSetpoint();
+        void readFace();
+
+    public:
+        gazeController(double period = GAZE_DEFAULT_PERIOD);
+
+        /**
+        * load the targets (GAZE_TARGETS ((name azimuth elevation) ...)) and the parameters of the scan and pursuit
+        */
+        bool configure(const yarp::os::Bottle& variables);
+        bool openPorts(const std::string& name);
+        void setGaze(yarp::dev::IGazeControl* iGaze_, std::mutex* gazeMutex_);
+
+        bool hasTarget(const std::string& name);
+
+        //the methods below are called with the gaze mutex locked
+        void fixate(const std::string& name);
+        void turn(double azimuth, double elevation);     //relative to the current goal
+        void scan();
+        void track();
+        void release();                                 //stop streaming, iGaze is used directly
+
+        /**
+        * look at a target for hold s and go back to what the gaze was doing (any other command ends it earlier)
+        */
+        void orient(const std::string& name, double hold);
+
+        /**
+        * true when the setpoint reached the goal (always true in the scan and track modes, they never end)
+        */
+        bool isSettled();
+
+        void run() override;
+
+        void interrupt();
+        void close();
+};
+
+#endif  //_GAZECONTROLLER_H_
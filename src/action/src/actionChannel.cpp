@@ -0,0 +1,127 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file actionChannel.cpp
+ * @brief Implementation of the action channels (see actionChannel.h).
+ */
+
+#include "iCub/actionChannel.h"
+#include "iCub/actionThread.h"
+
+using namespace yarp::os;
+using namespace std;
+
+actionChannel::actionChannel(actionThread* owner_, int priority_, double minInterval_){
+    owner = owner_;
+    priority = priority_;
+    minInterval = minInterval_;
+    preempted = false;
+}
+
+void actionChannel::push(const queuedCommand& command){
+    deque<queuedCommand> replaced;
+    {
+        lock_guard<mutex> lock(queueMutex);
+
+        //a new gaze target replaces the gaze commands not executed yet
+        if(command.gazeType == GAZE_TARGET){
+            for(deque<queuedCommand>::iterator it = queue.begin(); it != queue.end();){
+                if(it->gazeType != NOT_GAZE){
+                    cout << "Gaze command replaced: " << it->text << endl;
+                    replaced.push_back(*it);
+                    it = queue.erase(it);
+                }else
+                    ++it;
+            }
+        }
+        queue.push_back(command);
+        queueChanged.notify_all();
+    }
+
+    for(int i = 0; i < replaced.size(); i++)
+        owner->commandDone(replaced[i], COMMAND_SKIPPED);
+}
+
+void actionChannel::preempt(){
+    deque<queuedCommand> dropped;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        dropped.swap(queue);
+        preempted = true;
+        queueChanged.notify_all();
+    }
+
+    for(int i = 0; i < dropped.size(); i++)
+        owner->commandDone(dropped[i], COMMAND_PREEMPTED);
+}
+
+bool actionChannel::isPreempted(){
+    return preempted;
+}
+
+const atomic<bool>* actionChannel::getPreemptedFlag(){
+    return &preempted;
+}
+
+csvParser& actionChannel::getParser(){
+    return parser;
+}
+
+int actionChannel::getPriority(){
+    return priority;
+}
+
+bool actionChannel::isCancelled(){
+    return preempted || isStopping();
+}
+
+void actionChannel::run(){
+    double lastStart = -minInterval;
+    unique_lock<mutex> lock(queueMutex);
+
+    while(!isStopping()){
+        queueChanged.wait(lock, [this]{ return !queue.empty() || isStopping(); });
+        if(isStopping())
+            break;
+
+        //pace the channel (the wait ends earlier if the queue is preempted)
+        double wait = lastStart + minInterval - Time::now();
+        if(wait > 0.0){
+            queueChanged.wait_for(lock, chrono::duration<double>(wait), [this]{ return queue.empty() || isStopping(); });
+            continue;
+        }
+
+        queuedCommand command = queue.front();
+        queue.pop_front();
+        preempted = false;
+        lock.unlock();
+
+        //the commands dropped (already done or malformed) do not count for the pacing
+        int result = owner->executeCommand(command.text, *this);
+        if(result == COMMAND_DONE || result == COMMAND_PREEMPTED)
+            lastStart = Time::now();
+        owner->commandDone(command, result);
+
+        lock.lock();
+    }
+}
+
+void actionChannel::onStop(){
+    lock_guard<mutex> lock(queueMutex);
+    queueChanged.notify_all();
+}
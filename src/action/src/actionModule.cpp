@@ -133,6 +133,8 @@ bool actionModule::respond(const Bottle& command, Bottle& reply)
     string helpMessage =  string(getName().c_str()) + 
                 " commands are: \n" +  
                 "help \n" +
+                "ready : ok when the module is running (connections done), wait before \n" +
+                "period : period ticks overruns meanUsed maxUsed jitter (s) of the thread \n" +
                 "quit \n";
     reply.clear(); 
 
@@ -146,6 +148,12 @@ bool actionModule::respond(const Bottle& command, Bottle& reply)
         cout << helpMessage;
         reply.addString("ok");
     }
+    else if (command.get(0).asString()=="ready") {
+        reply.addString(pThread != nullptr && pThread->isRunning() ? "ok" : "wait");
+    }
+    else if (command.get(0).asString()=="period" && pThread != nullptr) {
+        pThread->addPeriodStats(reply);
+    }
     
     return true;
 }
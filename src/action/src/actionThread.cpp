@@ -33,17 +33,30 @@ using namespace boost;
 #define THPERIOD 0.5 //s
 #define NON_EXIST -1 //Must be the same value defined in objectPerception module
 
-actionThread::actionThread():PeriodicThread(THPERIOD) {
+touchReflexPort::touchReflexPort(){
+    thread = nullptr;
+}
+
+void touchReflexPort::setThread(actionThread* thread_){
+    thread = thread_;
+}
+
+void touchReflexPort::onRead(Bottle& skin){
+    if(thread != nullptr)
+        thread->touchReflex(skin.toString());
+}
+
+actionThread::actionThread():monitoredThread(THPERIOD) {
     robot = "icub";        
 }
 
-actionThread::actionThread(string _robot, ResourceFinder &_rf):PeriodicThread(THPERIOD){
+actionThread::actionThread(string _robot, ResourceFinder &_rf):monitoredThread(THPERIOD){
     robot = _robot;
     //configFile = _configFile;
     rf = _rf;
 }
 
-actionThread::actionThread(string _robot, ResourceFinder &_rf, string _robotPlatform):PeriodicThread(THPERIOD){
+actionThread::actionThread(string _robot, ResourceFinder &_rf, string _robotPlatform):monitoredThread(THPERIOD){
     robot = _robot;
     //configFile = _configFile;
     rf = _rf;
@@ -83,7 +96,7 @@ bool actionThread::openAllPorts(){
     }
 
     //Send action to ARE
-    if(!outputPortObjectToActAt.open(getName("/actionTargetARE:o").c_str())){
+    if(!are.open(getName("/actionTargetARE:o").c_str())){
         yError("unable to open port to send unmasked events ");
         return false;  // unable to open; let RFModule know so that it won't run
     }
@@ -94,69 +107,58 @@ bool actionThread::openAllPorts(){
         return false;
     }
 
-    //facial LED controller
-    if(!outputEmotionsPort.open(getName("/cmdFace:rpc").c_str())){
-        yDebug("unable to open port to send emotions LED");
+    //face seen by the perception, followed by the gaze in the trackFace mode
+    if(!gaze.openPorts(getName("")))
         return false;
-    }
 
-    //ctpService port Right Arm
-    outputMovementRAPort.setRpcMode(true);
-    yDebug("OPENING for right arm connection");
-    if(!outputMovementRAPort.open(getName("/movement/right_arm").c_str())){
-        yDebug("unable to open port to send right arm commands");
+    //skin events for the touch reflex, and the reflexes done for decision making
+    if(!inputTouchReflexPort.open(getName("/touch:i").c_str())){
+        yError("unable to open port to receive the skin events");
         return false;
     }
-
-    //ctpService port Left Arm
-    outputMovementLAPort.setRpcMode(true);
-    yDebug("OPENING for left arm connection");
-    if(!outputMovementLAPort.open(getName("/movement/left_arm").c_str())){
-        yDebug("unable to open port to send left arm commands");
-        return false;
-    }
-    
-    //ctpService port torso
-    outputMovementTPort.setRpcMode(true);
-    yDebug("OPENING for torso connection");
-    if(!outputMovementTPort.open(getName("/movement/torso").c_str())){
-        yDebug("unable to open port to send torso commands");
+    if(!outputReflexPort.open(getName("/reflex:o").c_str())){
+        yError("unable to open port to send the reflexes");
         return false;
     }
-    
-    //ctpService port Eyelids
-    if(robotPlatform == BERRY_ROBOT){
-        outRpcEyelids_berry.setRpcMode(true);
-        yInfo("OPENING port for eyelids control");
-        if(!outRpcEyelids_berry.open(getName("/movement/face").c_str())){
-            yInfo("unable to open port");
-            return false;
-        }
-    }
 
-    //port Emotions -- eyelids
-    if(robotPlatform == REDDY_ROBOT){
-        outRpcEyelids_reddy.setRpcMode(true);
-        yInfo("OPENING port for emotion control");
-        if(!outRpcEyelids_reddy.open(getName("/emotions/out").c_str())){
-            yInfo("unable to open port");
-            return false;
-        }
-    }
+    //facial LED controller, ctpService of the arms, torso and eyelids
+    if(!expression.openPorts(getName(""), robotPlatform))
+        return false;
 
     yInfo("OPENING port for eyelids control");
     if(!outputPortEyelids_icub.open(getName("/statusEyelids:o").c_str())){
         yInfo("unable to open port");
         return false;
     }
+
+    //completion of each command (id result command) - decision making advances when its commands are done
+    if(!outputDonePort.open(getName("/done:o").c_str())){
+        yError("unable to open port to send the completion of the commands");
+        return false;
+    }
+
+    //optional, "stat" replies speaking or quiet (iSpeak); without it the end of the speech is estimated
+    if(!speechStatusPort.open(getName("/speechStatus:rpc").c_str())){
+        yError("unable to open port to ask the status of the speech");
+        return false;
+    }
     
 
     return true;
 }
 
 void actionThread::initAllVars(){
-    turnFlag = 0;
-    timePastIdle = Time::now();
+    currentEyebrow = -1;
+    currentMouth = -1;
+    currentEyelids = -1;
+    currentPose = "";
+
+    reflexEnabled = false;
+    lastReflex = 0.0;
+    lastGazeCommand = 0.0;
+
+    for(int p = 0; p < NUMBER_OF_PRIORITIES; p++)
+        channels[p] = nullptr;
 
     middleX_leftCam = -1;
     middleY_leftCam = -1;
@@ -165,6 +167,7 @@ void actionThread::initAllVars(){
     
     iGaze = NULL;
     clientGazeCtrl = NULL;
+    gazeSpeedStale = false;
 
     yInfo("Opening the connection to the iKinGaze");
     optGaze.put("device", "gazecontrollerclient");
@@ -179,6 +182,7 @@ bool actionThread::waitForPortConnections(){
     yInfo("Connecting to the iKinGaze");
     if (clientGazeCtrl->isValid()){
         clientGazeCtrl->view(iGaze);
+        gaze.setGaze(iGaze, &gazeMutex);
         yInfo("Connected to the iKinGaze");
     }else{
         yError("Unable to connect to the iKinGaze");
@@ -187,37 +191,34 @@ bool actionThread::waitForPortConnections(){
 
     changeIGazeSpeed();
     
-    while(inputCommandSMPort.getInputCount() < 1);
-    //while(outputPortObjectToActAt.getOutputCount() < 1);
-    while(outputPortRecharge.getOutputCount() < 1);
+    connectionBarrier connections;
+    connections.configure(rf.findGroup("variables"));
+    connections.addInput(inputCommandSMPort);
+    connections.add(getName("/actionTargetARE:o"), [this]{ return are.getOutputCount() > 0; }, true);
+    connections.addOutput(outputPortRecharge);
 
-    if(robotPlatform == BERRY_ROBOT || robotPlatform == REDDY_ROBOT){
-        while(outputSpeechPort.getOutputCount() < 1);
-        while(outputEmotionsPort.getOutputCount() < 1);
-    }
+    if(robotPlatform == BERRY_ROBOT || robotPlatform == REDDY_ROBOT)
+        connections.addOutput(outputSpeechPort);
 
-    if(robotPlatform == BERRY_ROBOT)
-        while(outRpcEyelids_berry.getOutputCount() < 1);
+    connections.addOutput(outputPortEyelids_icub);
 
-    if(robotPlatform == REDDY_ROBOT)
-        while(outRpcEyelids_reddy.getOutputCount() < 1);
-
-    while(outputPortEyelids_icub.getOutputCount() < 1);
-
-    while(outputMovementRAPort.getOutputCount() < 1);
-    while(outputMovementLAPort.getOutputCount() < 1);
-    while(outputMovementTPort.getOutputCount() < 1);
+    connections.add("face, eyelids and movements", [this]{ return expression.isConnected(); });
  
-    return true;
+    return connections.wait();
 }
 
 bool actionThread::threadInit() {
+    configurePeriod(rf.findGroup("periods"), "action");
+
     filepath = rf.find("filepath").asString();
     filenameARE = filepath + filenameARE;
     filenameAllData = filepath + filenameAllData;
 
     initAllVars();
 
+    if(!gaze.configure(rf.findGroup("variables")) || !configureReflex(rf.findGroup("variables")))
+        return false;
+
     saveHeaders();
 
     if(!openAllPorts())
@@ -232,22 +233,81 @@ bool actionThread::threadInit() {
     }
 
     timeInitial = Time::now();
+
+    are.start();
+    gaze.start();
+
+    if(reflexEnabled){
+        inputTouchReflexPort.setThread(this);
+        inputTouchReflexPort.useCallback();
+    }
+
+    //the speech channel keeps a pace between sounds, the other channels run their commands as soon as the previous one is done
+    double speechInterval = rf.findGroup("variables").check("SPEECH_MIN_INTERVAL", Value(SPEECH_MIN_INTERVAL)).asFloat64();
+    for(int p = 0; p < NUMBER_OF_PRIORITIES; p++){
+        channels[p] = new actionChannel(this, p, p == PRIORITY_SPEECH ? speechInterval : 0.0);
+        channels[p]->start();
+    }
     
     return true;
 }
 
-void actionThread::run() {    
-    now = time(0);
-    char* timeNow_ = ctime(&now);
-    timeNow = timeNow_;
-    erase_all(timeNow, "\n");
-
-    colorToPlay = "";
+void actionThread::tick() {    
     readCommandSM();
 
     cout << "-------------------" << endl;
 }
 
+bool actionThread::configureReflex(const Bottle& variables){
+    reflexEnabled = variables.check("TOUCH_REFLEX", Value(0)).asInt32() == 1;
+    reflexHold = variables.check("TOUCH_REFLEX_HOLD", Value(3.0)).asFloat64();
+    reflexRefractory = variables.check("TOUCH_REFLEX_REFRACTORY", Value(4.0)).asFloat64();
+    reflexAfterGaze = variables.check("TOUCH_REFLEX_AFTER_GAZE", Value(1.0)).asFloat64();
+    if(!reflexEnabled)
+        return true;
+
+    //torso, leftHand, leftForearm, leftUpper, rightHand, rightForearm, rightUpper
+    Bottle* targetsList = variables.find("TOUCH_REFLEX_TARGETS").asList();
+    if(targetsList == nullptr || targetsList->size() != NUMBER_OF_SKIN_PARTS){
+        yError("TOUCH_REFLEX_TARGETS needs a gaze target for each of the %d parts of the skin", NUMBER_OF_SKIN_PARTS);
+        return false;
+    }
+    for(int i = 0; i < NUMBER_OF_SKIN_PARTS; i++){
+        reflexTargets[i] = targetsList->get(i).asString();
+        if(!gaze.hasTarget(reflexTargets[i])){
+            yError("TOUCH_REFLEX_TARGETS: %s is not in GAZE_TARGETS", reflexTargets[i].c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+void actionThread::touchReflex(const string& skinInput){
+    int origin, side;
+    if(!parseSkinTouch(skinInput, origin, side) || origin == SKIN_NO_TOUCH)
+        return;
+
+    //inhibited: just done, decision making is moving the gaze, ARE is moving the robot, or the robot is asleep
+    double now = Time::now();
+    if(now - lastReflex < reflexRefractory || now - lastGazeCommand < reflexAfterGaze || are.isBusy() || currentEyelids == EYELIDS_CLOSE)
+        return;
+    lastReflex = now;
+
+    {
+        lock_guard<mutex> lock(gazeMutex);
+        gaze.orient(reflexTargets[origin], reflexHold);
+    }
+    yInfo("Touch reflex: looking at %s", reflexTargets[origin].c_str());
+
+    if(outputReflexPort.getOutputCount()){
+        Bottle& reflex = outputReflexPort.prepare();
+        reflex.clear();
+        reflex.addInt16(origin);
+        reflex.addString(reflexTargets[origin]);
+        outputReflexPort.write();
+    }
+}
+
 void actionThread::changeIGazeSpeed(){
     double eyesTime, neckTime;
 
@@ -257,8 +317,8 @@ void actionThread::changeIGazeSpeed(){
     cout << neckTime << endl;
 
     cout << iGaze->blockNeckRoll() << endl; //block roll, use only pitch and yaw, start the robot in normal orientation
-    cout << iGaze->setEyesTrajTime(0.7) << endl; //0.5 pilot, 0.2 orig, 0.7
-    cout << iGaze->setNeckTrajTime(0.9) << endl; //0.9 pilot, 0.8 orig, 0.9
+    cout << iGaze->setEyesTrajTime(EYES_TRAJ_TIME) << endl;
+    cout << iGaze->setNeckTrajTime(NECK_TRAJ_TIME) << endl;
 
     iGaze->getEyesTrajTime(&eyesTime);
     iGaze->getNeckTrajTime(&neckTime);
@@ -266,146 +326,319 @@ void actionThread::changeIGazeSpeed(){
     cout << neckTime << endl;
 }
 
+//called with gazeMutex taken
+void actionThread::restoreIGazeSpeed(){
+    //ARE overwrites the iGaze speed defined in init, it is checked once all its requests are done
+    if(!gazeSpeedStale || are.isBusy() || iGaze == NULL)
+        return;
+    gazeSpeedStale = false;
 
-void actionThread::readCommandSM(){
-    if(inputCommandSMPort.getInputCount()){
-        Bottle* bottleCommandSM = nullptr;
-        bottleCommandSM = inputCommandSMPort.read(false);
-
-        if(bottleCommandSM != nullptr){
-            string commandData = bottleCommandSM->toString();
-            bottleCommandSM->clear();
-            vector<string> fields;
-
-            cout << "This is the input: "<< commandData << endl;
-            erase_all(commandData, "\"");
-            split(fields, commandData, is_any_of( "," ), token_compress_on);
-
-            string actionType = fields [0];
-            cout << "action type is: " << actionType << endl;
-
-            if(actionType.compare("recharge") == 0){
-                cout<<"Recharging"<<endl;
-                if(outputPortRecharge.getOutputCount()){//Send a message to the simulated sensor to simulate the recharging action (and update the battery value)
-                    Bottle rechargeBottle;
-                    rechargeBottle.clear();           
-                    rechargeBottle.addInt16(1);
-                    outputPortRecharge.prepare() = rechargeBottle;
-                    outputPortRecharge.write();
-                }
-            }else if(actionType.compare("eyelids") == 0){
-                moveEyelids(stod(fields[1]), stod(fields[2]), fields[3]);
-            }else if(actionType.compare("homeARE") == 0){
-                homeARE();
-                writeToARE();
-            }
-            else if(actionType.compare("powerOff") == 0){
-
-            }else if(actionType.compare("play") == 0){
-                //topXLeft, topYLeft, bottomXLeft, bottomYLeft, topXRight, topYRight, bottomXRight, bottomYRight;
-                colorToPlay = fields[9];
-                computeTargetCentroid(stoi(fields[1]), stoi(fields[2]), stoi(fields[3]), stoi(fields[4]), stoi(fields[5]), stoi(fields[6]), stoi(fields[7]), stoi(fields[8]));
-                actARE("point", middleX_leftCam, middleY_leftCam, middleX_rightCam, middleY_rightCam);
-                writeToARE();
-            }else if(actionType.compare("speech") == 0)
-                speakText(fields[1]);
-            else if(actionType.compare("face") == 0)
-                setFaceModular(fields[1], fields[2]);
-            else if(actionType.compare("gaze") == 0){ // "gaze functionName functionParameter"
-                string functionName = fields [1];
-                cout<<"The function Name is: "<<functionName<<endl;
-
-                if(functionName.compare("turnHeadAngle") == 0)
-                    turnHeadAngle(stof(fields[2]));
-                
-                else if(functionName.compare("lookAtPoint") == 0){
-                    if(fields.size() == 5)//gaze lookAtPoint pointX pointY camera
-                        lookAtPointMono(stoi(fields[2]), stoi(fields[3]), stoi(fields[4]));
-                    else //gaze lookAtPoint pointX_Left pointY_Left pointX_Right pointY_Right
-                        lookAtPointStereo(stoi(fields[2]), stoi(fields[3]), stoi(fields[4]), stoi(fields[5]));
-                }
-
-                else if(functionName.compare("lookAround") == 0)
-                    lookAround();
-                
-                else if(functionName.compare("turnHeadTwoAngles") == 0)
-                    turnHeadTwoAngles(stof(fields[2]), stof(fields[3]));
-                
-                else if(functionName.compare("moveHeadDirection") == 0)
-                    moveHeadDirection(fields[2]);
-            }else if(actionType.compare("action") == 0)
-                executeMovement(stod(fields[1]), stod(fields[2]), " ", fields[3]);
-            
-            saveData(actionType);
-        } 
-    }
-}
-
-void actionThread::writeToARE(){
-    cout<<"Before ARE"<<endl;
-    if(outputPortObjectToActAt.getOutputCount()){
-        cout<<action.toString()<<endl;
-        //outputPortObjectToActAt.prepare() = action;
-        //outputPortObjectToActAt.write();
-        Bottle reply;
-        outputPortObjectToActAt.write(action, reply);
-        cout<<"Reply ARE: "<<reply.toString()<<endl;
-    }
-    changeIGazeSpeed();//ARE overwrites the iGaze speed defined in init - so need to redefine
+    double eyesTime, neckTime;
+    iGaze->getEyesTrajTime(&eyesTime);
+    iGaze->getNeckTrajTime(&neckTime);
+    if(fabs(eyesTime - EYES_TRAJ_TIME) > 1e-3 || fabs(neckTime - NECK_TRAJ_TIME) > 1e-3){
+        yInfo("ARE changed the gaze speed, setting it again");
+        changeIGazeSpeed();
+    }
 }
 
-void actionThread::turnHeadAngle(float angle){ 
-    Vector ang(3);
 
-    if (iGaze != NULL){
-        iGaze->getAngles(ang);
-        yDebug("angles before rotate x=%f, y=%f, z=%f", ang[0], ang[1], ang[2]);
+void actionThread::readCommandSM(){
+    //move all the commands received to the queue of their channel
+    while(inputCommandSMPort.getInputCount() && inputCommandSMPort.getPendingReads() > 0){
+        Bottle* bottleCommandSM = inputCommandSMPort.read(false);
+        if(bottleCommandSM == nullptr)
+            break;
+
+        //"command" or "command" id, the id is sent back in the completion event
+        string commandData = bottleCommandSM->get(0).asString();
+        int id = bottleCommandSM->size() > 1 ? bottleCommandSM->get(1).asInt32() : NO_COMMAND_ID;
+        bottleCommandSM->clear();
+        erase_all(commandData, "\"");
+        queueCommand(commandData, id);
+    }
+}
 
-        yInfo("Turning head to %f", (angle));
-        ang[0] += angle;
-        iGaze->lookAtAbsAngles(ang);
-        //iGaze->waitMotionDone();
+int actionThread::getPriority(const string& actionType){
+    if(actionType == "stop" || actionType == "powerOff" || actionType == "recharge")
+        return PRIORITY_SAFETY;
+    if(actionType == "eyelids" || actionType == "face")
+        return PRIORITY_FACE;
+    if(actionType == "gaze")
+        return PRIORITY_GAZE;
+    if(actionType == "speech")
+        return PRIORITY_SPEECH;
+    return PRIORITY_GESTURE;
+}
+
+void actionThread::queueCommand(const string& commandData, int id){
+    queuedCommand command;
+    command.text = commandData;
+    command.gazeType = NOT_GAZE;
+    command.id = id;
+
+    csvParser parser;
+    parser.parseLine(commandData, "commandSM");
+    string actionType = parser.asString(0);
+    if(actionType == "gaze"){
+        lastGazeCommand = Time::now();
+        string functionName = parser.asString(1);
+        command.gazeType = (functionName == "moveHeadDirection" || functionName == "lookAtPoint" || functionName == "trackFace") ? GAZE_TARGET : GAZE_RELATIVE;
+    }
 
-        iGaze->getAngles(ang);
-        yDebug("angles after rotate x=%f, y=%f, z=%f", ang[0], ang[1], ang[2]);
+    //stop is done here, before the next commands are queued: it preempts the lower channels, queued or in execution
+    if(actionType == "stop"){
+        stopLowerPriorities();
+        commandDone(command, COMMAND_DONE);
+        return;
     }
+
+    channels[getPriority(actionType)]->push(command);
 }
 
-void actionThread::lookAround(){
-   cout<<"Looking around"<<endl;
-   //Natural movement 
-    int rotationAngle = (1 - 2*(rand() % 2)) * 10.0;
-    float timeElapsedGaze = 3 + (rand() % 3);  //random time between 2.5 and 4.5 seconds (5-7)
-
-    if(Time::now() - timePastIdle > timeElapsedGaze){ // try out longer periods after movement
-        if(turnFlag < 3){
-            turnHeadAngle(rotationAngle);
-            turnFlag++;
+void actionThread::stopLowerPriorities(){
+    for(int p = PRIORITY_PREEMPTABLE; p < NUMBER_OF_PRIORITIES; p++)
+        channels[p]->preempt();
+
+    lock_guard<mutex> lock(gazeMutex);
+    gaze.release();
+    if(iGaze != NULL)
+        iGaze->stopControl();
+}
+
+int actionThread::executeCommand(const string& commandData, actionChannel& channel){
+    csvParser& commandParser = channel.getParser();
+    cout << "This is the input: "<< commandData << endl;
+    commandParser.parseLine(commandData, "commandSM");
+
+    string actionType = commandParser.asString(0);
+    cout << "action type is: " << actionType << endl;
+
+    if(actionType.compare("recharge") == 0){
+        cout<<"Recharging"<<endl;
+        if(outputPortRecharge.getOutputCount()){//Send a message to the simulated sensor to simulate the recharging action (and update the battery value)
+            Bottle rechargeBottle;
+            rechargeBottle.clear();           
+            rechargeBottle.addInt16(1);
+            outputPortRecharge.prepare() = rechargeBottle;
+            outputPortRecharge.write();
+        }
+    }else if(actionType.compare("eyelids") == 0){
+        double timeEyelids = commandParser.asDouble(1), offsetEyelids = commandParser.asDouble(2);
+        string movementEyelids = commandParser.asString(3);
+        if(!commandOk(commandParser))
+            return COMMAND_FAILED;
+        if(eyelidsFromName(movementEyelids) == currentEyelids){
+            cout << "Eyelids already " << movementEyelids << endl;
+            return COMMAND_SKIPPED;
+        }
+        waitFor(moveEyelids(timeEyelids, offsetEyelids, movementEyelids), channel);
+        currentEyelids = eyelidsFromName(movementEyelids);
+    }else if(actionType.compare("homeARE") == 0){
+        homeARE();
+        writeToARE(channel);
+        currentPose = "";
+    }
+    else if(actionType.compare("powerOff") == 0){
+
+    }else if(actionType.compare("play") == 0){
+        //topXLeft, topYLeft, bottomXLeft, bottomYLeft, topXRight, topYRight, bottomXRight, bottomYRight;
+        int box[8];
+        for(int k = 0; k < 8; k++)
+            box[k] = commandParser.asInt(k + 1);
+        colorToPlay = commandParser.asString(9);
+        if(!commandOk(commandParser))
+            return COMMAND_FAILED;
+        computeTargetCentroid(box[0], box[1], box[2], box[3], box[4], box[5], box[6], box[7]);
+        actARE("point", middleX_leftCam, middleY_leftCam, middleX_rightCam, middleY_rightCam);
+        writeToARE(channel);
+        currentPose = "";
+    }else if(actionType.compare("speech") == 0){
+        string text = commandParser.asString(1);
+        if(!commandOk(commandParser))
+            return COMMAND_FAILED;
+        speakText(text);
+        waitSpeechDone(channel);
+    }else if(actionType.compare("face") == 0){
+        int eyebrow = eyebrowFromName(commandParser.asString(1)), mouth = mouthFromName(commandParser.asString(2));
+        if(!commandOk(commandParser))
+            return COMMAND_FAILED;
+        //MOUTH_NONE and EYEBROW_NONE do not change that part of the face
+        if((eyebrow == EYEBROW_NONE || eyebrow == currentEyebrow) && (mouth == MOUTH_NONE || mouth == currentMouth)){
+            cout << "Face already set" << endl;
+            return COMMAND_SKIPPED;
+        }
+        expression.setFace(eyebrow, mouth);
+        if(eyebrow != EYEBROW_NONE)
+            currentEyebrow = eyebrow;
+        if(mouth != MOUTH_NONE)
+            currentMouth = mouth;
+    }else if(actionType.compare("gaze") == 0){ // "gaze functionName functionParameter"
+        unique_lock<mutex> lock(gazeMutex);
+        restoreIGazeSpeed();
+        string functionName = commandParser.asString(1);
+        cout<<"The function Name is: "<<functionName<<endl;
+
+        if(functionName.compare("turnHeadAngle") == 0){
+            float angle = commandParser.asFloat(2);
+            if(!commandOk(commandParser))
+                return COMMAND_FAILED;
+            turnHeadAngle(angle);
+        }
+
+        else if(functionName.compare("lookAtPoint") == 0){
+            if(commandParser.size() == 5){//gaze lookAtPoint pointX pointY camera
+                int pointX = commandParser.asInt(2), pointY = commandParser.asInt(3), camera = commandParser.asInt(4);
+                if(!commandOk(commandParser))
+                    return COMMAND_FAILED;
+                lookAtPointMono(pointX, pointY, camera);
+            }else{ //gaze lookAtPoint pointX_Left pointY_Left pointX_Right pointY_Right
+                int pointXLeft = commandParser.asInt(2), pointYLeft = commandParser.asInt(3), pointXRight = commandParser.asInt(4), pointYRight = commandParser.asInt(5);
+                if(!commandOk(commandParser))
+                    return COMMAND_FAILED;
+                lookAtPointStereo(pointXLeft, pointYLeft, pointXRight, pointYRight);
+            }
+        }
+
+        else if(functionName.compare("lookAround") == 0)
+            lookAround();
+
+        else if(functionName.compare("trackFace") == 0)
+            gaze.track();
+        
+        else if(functionName.compare("turnHeadTwoAngles") == 0){
+            float angleX = commandParser.asFloat(2), angleY = commandParser.asFloat(3);
+            if(!commandOk(commandParser))
+                return COMMAND_FAILED;
+            turnHeadTwoAngles(angleX, angleY);
+        }
+        
+        else if(functionName.compare("moveHeadDirection") == 0){
+            string direction = commandParser.asString(2);
+            if(!commandOk(commandParser))
+                return COMMAND_FAILED;
+            moveHeadDirection(direction);
         }
-        else{
-            moveHeadDirection("home");
-            turnFlag = 0;
+        lock.unlock();
+        waitGazeDone(channel);
+    }else if(actionType.compare("action") == 0){
+        double timeMovement = commandParser.asDouble(1), offsetMovement = commandParser.asDouble(2);
+        string movement = commandParser.asString(3);
+        if(!commandOk(commandParser))
+            return COMMAND_FAILED;
+        //a movement with only one step is a pose, nothing to do if the arms are already there
+        bool pose = expression.getMovementSteps(rf, movement) == 1;
+        if(pose && movement == currentPose){
+            cout << "Already in " << movement << endl;
+            return COMMAND_SKIPPED;
         }
-        timePastIdle = Time::now();
-    }        
+        waitFor(expression.executeMovement(rf, timeMovement, offsetMovement, " ", movement, channel.getPreemptedFlag()), channel);
+        currentPose = pose && !channel.isPreempted() ? movement : "";
+    }
+    
+    saveData(actionType);
+    return channel.isPreempted() ? COMMAND_PREEMPTED : COMMAND_DONE;
 }
 
-void actionThread::turnHeadTwoAngles(float angleX, float angleY){
-    Vector ang(3);
+void actionThread::waitFor(double duration, actionChannel& channel){
+    double end = Time::now() + duration;
+    while(Time::now() < end && !channel.isCancelled())
+        Time::delay(DONE_POLL_PERIOD);
+}
+
+void actionThread::waitGazeDone(actionChannel& channel){
+    double start = Time::now();
+    while(!channel.isCancelled() && Time::now() - start < GAZE_DONE_TIMEOUT){
+        bool done;
+        {
+            lock_guard<mutex> lock(gazeMutex);
+            done = gaze.isSettled();
+            if(done && iGaze != NULL)
+                iGaze->checkMotionDone(&done);
+        }
+        if(done)
+            return;
+        Time::delay(DONE_POLL_PERIOD);
+    }
+}
+
+void actionThread::waitSpeechDone(actionChannel& channel){
+    //without the status of the speech module the end of the sentence is estimated
+    if(!speechStatusPort.getOutputCount()){
+        waitFor(SPEECH_TIME_NO_STATUS, channel);
+        return;
+    }
 
-    if (iGaze != NULL){
-        iGaze->getAngles(ang);
-        yDebug("angles before rotate x=%f, y=%f, z=%f", ang[0], ang[1], ang[2]);
+    //the sentence may take a while to start
+    Time::delay(DONE_POLL_PERIOD);
+    double start = Time::now();
+    while(!channel.isCancelled() && Time::now() - start < SPEECH_DONE_TIMEOUT){
+        Bottle cmd, reply;
+        cmd.addString("stat");
+        if(!speechStatusPort.write(cmd, reply) || reply.get(0).asString() != "speaking")
+            return;
+        Time::delay(DONE_POLL_PERIOD);
+    }
+}
+
+void actionThread::commandDone(const queuedCommand& command, int result){
+    cout << "Command " << commandResultName(result) << ": " << command.text << endl;
 
-        yInfo("Turning head to %f, %f", (angleX), (angleY));
-        ang[0] += angleX;//Azimuthal (horizontal) 
-        ang[1] += angleY;//elevation (vertical) 
-        iGaze->lookAtAbsAngles(ang);
-        //iGaze->waitMotionDone();
+    lock_guard<mutex> lock(doneMutex);
+    if(outputDonePort.getOutputCount()){
+        Bottle& event = outputDonePort.prepare();
+        event.clear();
+        event.addInt32(command.id);
+        event.addString(commandResultName(result));
+        event.addString(command.text);
+        outputDonePort.writeStrict();
+    }
+}
 
-        iGaze->getAngles(ang);
-        yDebug("angles after rotate x=%f, y=%f, z=%f", ang[0], ang[1], ang[2]);
+bool actionThread::commandOk(csvParser& commandParser){
+    if(commandParser.ok())
+        return true;
+    yError("Malformed command ignored: %s", commandParser.getError().c_str());
+    return false;
+}
+
+void actionThread::writeToARE(actionChannel& channel){
+    if(!are.getOutputCount())
+        return;
+
+    cout<<action.toString()<<endl;
+    {
+        lock_guard<mutex> lock(gazeMutex);
+        gaze.release();//ARE moves the head too
+        gazeSpeedStale = true;
+    }
+    future<Bottle> reply = are.send(action);
+
+    //the other channels keep going meanwhile, a stop leaves the request to ARE and frees the channel
+    while(reply.wait_for(chrono::duration<double>(DONE_POLL_PERIOD)) != future_status::ready){
+        if(channel.isCancelled()){
+            yWarning("ARE request left running: %s", action.toString().c_str());
+            return;
+        }
     }
+
+    lock_guard<mutex> lock(gazeMutex);
+    restoreIGazeSpeed();
+}
+
+void actionThread::turnHeadAngle(float angle){ 
+    yInfo("Turning head to %f", (angle));
+    gaze.turn(angle, 0.0);
+}
+
+void actionThread::lookAround(){
+    cout<<"Looking around"<<endl;
+    gaze.scan();
+}
+
+void actionThread::turnHeadTwoAngles(float angleX, float angleY){
+    yInfo("Turning head to %f, %f", (angleX), (angleY));
+    gaze.turn(angleX, angleY);//Azimuthal (horizontal), elevation (vertical)
 }
 
 void actionThread::lookAtPointMono(int pointX, int pointY, int camera){
@@ -414,6 +647,7 @@ void actionThread::lookAtPointMono(int pointX, int pointY, int camera){
     px[0] = pointX;
     px[1] = pointY;
 
+    gaze.release();
     if(iGaze != NULL)
         iGaze->lookAtMonoPixel(camera, px, z);  //left camera = 0, right camera = 1
 }
@@ -428,6 +662,7 @@ void actionThread::lookAtPointStereo(int pointX_Left, int pointY_Left, int point
     pxR[0] = pointX_Right;
     pxR[1] = pointY_Right;
 
+    gaze.release();
     if(iGaze != NULL)
         iGaze->lookAtStereoPixelsSync(pxL, pxR);
         //igaze->waitMotionDone();                        // wait until the operation is done  
@@ -444,74 +679,6 @@ void actionThread::speakText(string speech){
     }
 }
 
-vector<string> getValuesLEDSModular(string affectEyebr, string affectMouth){
-    vector<string> valueLEDS;
-    valueLEDS.push_back("");
-    valueLEDS.push_back("");
-    valueLEDS.push_back("");
-   
-    if(affectEyebr.compare("raise") == 0){
-        valueLEDS[0] = "L01"; //04
-        valueLEDS[1] = "R01"; //04
-    }else if(affectEyebr.compare("lower") == 0){
-        valueLEDS[0] = "L04"; //01
-        valueLEDS[1] = "R04"; //01
-    }else if(affectEyebr.compare("neutral") == 0){
-        valueLEDS[0] = "L02"; //02
-        valueLEDS[1] = "R02"; //02
-    }else if(affectEyebr.compare("evil") == 0){
-        valueLEDS[0] = "L05"; //02
-        valueLEDS[1] = "R05"; //02
-    }else if(affectEyebr.compare("cunny") == 0){
-        valueLEDS[0] = "L07"; 
-        valueLEDS[1] = "R07"; 
-    }
-
-    if(affectMouth.compare("smile") == 0)
-        valueLEDS[2] = "M01"; //0B
-    else if(affectMouth.compare("frown") == 0)
-        valueLEDS[2] = "M02";//"M38";
-    else if(affectMouth.compare("open") == 0)      
-        valueLEDS[2] = "M03"; //16
-    else if(affectMouth.compare("sad") == 0)
-        valueLEDS[2] = "M02";//"M18";
-    else if(affectMouth.compare("neutral") == 0)
-        valueLEDS[2] = "M00";//M0A, 08
-    else if(affectMouth.compare("evil") == 0)
-        valueLEDS[2] = "M05";//M0A, 08
-    else if(affectMouth.compare("cunny") == 0)
-        valueLEDS[2] = "M07";//M0A, 08
-    
-    return valueLEDS;
-}
-
-void actionThread::setFaceModular(string affectEyebr, string affectMouth){
-    vector<string> vals;
-
-    vals = getValuesLEDSModular(affectEyebr, affectMouth);
-
-    string lebVal = vals[0];
-    string rebVal = vals[1];
-    string mouVal = vals[2];
-    
-    Bottle out;
-
-    if(outputEmotionsPort.getOutputCount()){
-        out.fromString(lebVal);
-        outputEmotionsPort.write(out);
-        //Time::delay(0.05);
-        out.clear();
-
-        out.fromString(rebVal);
-        outputEmotionsPort.write(out);
-        //Time::delay(0.05);
-        out.clear();
-
-        out.fromString(mouVal);
-        outputEmotionsPort.write(out);
-    }
-}
-
 void actionThread::computeTargetCentroid(int topXLeft, int topYLeft, int bottomXLeft, int bottomYLeft, int topXRight, int topYRight, int bottomXRight, int bottomYRight){
     middleX_leftCam = (topXLeft + bottomXLeft)/2;
     middleY_leftCam = (topYLeft + bottomYLeft)/2;
@@ -525,105 +692,20 @@ void actionThread::computeTargetCentroid(int topXLeft, int topYLeft, int bottomX
 
  //-----------------------------------------------------------------------
 void actionThread::moveHeadDirection(string direction){
-    Vector ang(3);
-    
-    if(iGaze != NULL){
-        iGaze->getAngles(ang);
-        //yDebug("angles before move x=%f, y=%f, z=%f", ang[0], ang[1], ang[2]);
-
-        if(direction == "up"){
-            yInfo("Moving head UP");
-            ang[1] += 10;
-        }
-        else if(direction == "down"){
-            yInfo("Moving head DOWN");
-            ang[1] -= 10;
-        }
-        else if(direction == "left"){
-            yInfo("Moving head LEFT");
-            ang[0] -= 10; //20
-        }
-        else if(direction == "right"){
-            yInfo("Moving head RIGHT");
-            ang[0] += 10;
-        }
-        else if(direction == "home"){
-            yInfo("head home");
-            ang[0] = 0.0;
-            ang[1] = 0.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "homeDown"){
-            yInfo("head home down");
-            ang[0] = 0.0;
-            ang[1] = -25.00;
-            ang[2] = 0.0;
-        }
-        else if(direction == "leftDown"){
-            yInfo("head home left down");
-            ang[0] = -15.0;
-            ang[1] = -30.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "rightDown"){
-            yInfo("head home right down");
-            ang[0] = 15.0;
-            ang[1] = -30.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "leftDownUpper"){
-            yInfo("head home left down");
-            ang[0] = -25.0;
-            ang[1] = -30.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "rightDownUpper"){
-            yInfo("head home right down");
-            ang[0] = 25.0;
-            ang[1] = -30.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "rightUp"){
-            yInfo("head home right up");
-            ang[0] = 35.0;
-            ang[1] = 15.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "farDiagonalRight_Down"){//Define correct values
-            yInfo("head far Diagonal Right");
-            ang[0] = 30.0;
-            ang[1] = -25.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "closeDiagonalRight_Down"){
-            yInfo("head close Diagonal Right");
-            ang[0] = 30.0;
-            ang[1] = -35.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "center_Down"){
-            yInfo("head center");
-            ang[0] = 0.0;
-            ang[1] = -35.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "farDiagonalLeft_Down"){
-            yInfo("head far Diagonal Left");
-            ang[0] = -35.0;
-            ang[1] = -20.0;
-            ang[2] = 0.0;
-        }
-        else if(direction == "closeDiagonalLeft_Down"){
-            yInfo("head closeDiagonalLeft");
-            ang[0] = -40.0;
-            ang[1] = -35.0;
-            ang[2] = 0.0;
-        }
-        iGaze->lookAtAbsAngles(ang);
-        iGaze->waitMotionDone();
-/*         iGaze->getAngles(ang);
-        yDebug("angles after move x=%f, y=%f, z=%f", ang[0], ang[1], ang[2]); */
-    }
+    //named targets are in GAZE_TARGETS, the others turn from the current target
+    if(gaze.hasTarget(direction)){
+        yInfo("Moving head to %s", direction.c_str());
+        gaze.fixate(direction);
+    }else if(direction == "up")
+        gaze.turn(0.0, 10.0);
+    else if(direction == "down")
+        gaze.turn(0.0, -10.0);
+    else if(direction == "left")
+        gaze.turn(-10.0, 0.0); //20
+    else if(direction == "right")
+        gaze.turn(10.0, 0.0);
+    else
+        yWarning("Unknown gaze direction: %s", direction.c_str());
 }
 
 void actionThread::actARE(string actionARE, int pXL, int pYL, int pXR, int pYR){
@@ -662,106 +744,31 @@ void actionThread::actARE(string actionARE, int pXL, int pYL, int pXR, int pYR){
     action.addString("all");
  }
 
-void actionThread::executeMovement(const double time, const double offset, const string bodyPart, const string movement){
-    // send name of gesture to perform, joint positions and body parts are loaded from .ini file
-    // processing the config file
-    Bottle listOfJointPos = rf.findGroup("movement").findGroup(movement).findGroup("seq").tail();
-    Bottle timeNew = rf.findGroup("movement").findGroup(movement).findGroup("time").tail();
-    Bottle offsetNew = rf.findGroup("movement").findGroup(movement).findGroup("offset").tail();
-    Bottle bodyPartNew = rf.findGroup("movement").findGroup(movement).findGroup("bodyPart").tail();
-
-    string tmpJointPos;
-    string tmpBodyPart;
-
-    string testInput = "input";
-
-    //for each separate gesture
-    for (int i = 0; i < listOfJointPos.size(); ++i){
-        tmpJointPos = listOfJointPos.get(i).asString();
-        Bottle tmpList = rf.findGroup("movement").findGroup(tmpJointPos).tail();
-
-        Bottle cmd;
-        cmd.clear();
-        cmd.addVocab32("ctpq");
-        cmd.addVocab32("time");
-        cmd.addFloat64(time);
-        cmd.addVocab32("off");
-        cmd.addFloat64(offset);
-        cmd.addVocab32("pos");
-        cmd.addList() = rf.findGroup("movement").findGroup(tmpJointPos).tail();
-
-        Bottle response;
-        response.clear();
-
-        if(testInput.compare(bodyPartNew.get(i).asString()) != 0)       
-            tmpBodyPart = bodyPartNew.get(i).asString();
-        else
-            tmpBodyPart = bodyPart;
-        
-        if(tmpBodyPart.compare("rightArm") == 0){ 
-            cout << "Right Arm" << endl;
-            if (outputMovementRAPort.getOutputCount()) 
-                outputMovementRAPort.write(cmd,response);
-        }
-        
-        if(tmpBodyPart.compare("leftArm") == 0){
-            cout << "Left Arm" << endl;
-            if(outputMovementLAPort.getOutputCount()) 
-                outputMovementLAPort.write(cmd,response);
-        }
-        
-        if(tmpBodyPart.compare("torso") == 0){ 
-            cout << "Torso" << endl;
-            if(outputMovementTPort.getOutputCount())                        
-                outputMovementTPort.write(cmd,response);
-        }
-    }
+string actionThread::getTimeNow(){
+    time_t now = time(0);
+    string timeNow = ctime(&now);
+    erase_all(timeNow, "\n");
+    return timeNow;
 }
 
-
 void actionThread::saveDataARE(int pXL, int pYL, int pXR, int pYR){
+    lock_guard<mutex> lock(dataMutex);
     ofstream fout;
     fout.open(filenameARE, ios::app); 
 
-    fout << timeNow << ',' << to_string(Time::now() - timeInitial) << ',' << colorToPlay << "," << to_string(pXL) << "," << to_string(pYL) << "," << to_string(pXR) << "," << to_string(pYR);
+    fout << getTimeNow() << ',' << to_string(Time::now() - timeInitial) << ',' << colorToPlay << "," << to_string(pXL) << "," << to_string(pYL) << "," << to_string(pXR) << "," << to_string(pYR);
     fout << "\n";
 
     fout.close( );
 }
 
 
-void actionThread::moveEyelids(const double time, const double offset, string movement){
-    if(robotPlatform == REDDY_ROBOT){// Reddy controls the eyelids from the emotionInterface
-        Bottle cmd;
-        Bottle response;
-
-        cmd.clear();
-        response.clear();
-        cmd.addVocab32("set");
-        cmd.addVocab32("raw");
-        cmd.addVocab32(Vocab32::encode(getEyelidsPose(movement).toString()));
-
-        cout<<cmd.toString()<<endl;
-        outRpcEyelids_reddy.write(cmd, response);
-    }else if(robotPlatform == BERRY_ROBOT){//Berry controls the eyelids from the ctpService
-        Bottle cmd;
-        Bottle response;
-        cmd.clear();
-        response.clear();
+double actionThread::moveEyelids(const double time, const double offset, string movement){
+    double duration = expression.moveEyelids(time, offset, eyelidsFromName(movement));
 
-        cmd.addVocab32("ctpq");
-        cmd.addVocab32("time");
-        cmd.addFloat64(time);
-        cmd.addVocab32("off");
-        cmd.addFloat64(offset);
-        cmd.addVocab32("pos");
-        cmd.addList() = getEyelidsPose(movement);
-
-        cout<<cmd.toString()<<endl;
-        outRpcEyelids_berry.write(cmd, response);
-    }
     outputPortEyelids_icub.prepare() = updateStatusEyelids_ToPerception(movement);
     outputPortEyelids_icub.write();
+    return duration;
 }
 
 Bottle actionThread::updateStatusEyelids_ToPerception(string movement){
@@ -776,25 +783,6 @@ Bottle actionThread::updateStatusEyelids_ToPerception(string movement){
     return bEyelides;
 }
 
-Bottle actionThread::getEyelidsPose(string movement){
-    Bottle bEyelides;
-    bEyelides.clear();
-
-    if(robotPlatform == REDDY_ROBOT){
-        if(movement == "open")
-            bEyelides.addString("S01");
-        else
-            bEyelides.addString("S64");
-    }else if(robotPlatform == BERRY_ROBOT){
-        if(movement == "open")
-            bEyelides.addInt16(1);
-        else
-            bEyelides.addInt16(64);
-    }
-
-    return bEyelides;
-}
-
 void actionThread::saveHeaders(){
     //Save header in the file
     ofstream fout; 
@@ -809,10 +797,11 @@ void actionThread::saveHeaders(){
 }
 
 void actionThread::saveData(string actionType){
+    lock_guard<mutex> lock(dataMutex);
     ofstream fout;
     fout.open(filenameAllData, ios::app);
     
-    fout << timeNow << ',' << to_string(Time::now() - timeInitial) << ',' << actionType;
+    fout << getTimeNow() << ',' << to_string(Time::now() - timeInitial) << ',' << actionType;
 
     fout << "\n";
     fout.close();
@@ -824,29 +813,39 @@ bool actionThread::processing(){
 }
 
 void actionThread::threadRelease(){
+    gaze.stop();
+    gaze.interrupt();
+    inputTouchReflexPort.interrupt();
+    outputReflexPort.interrupt();
     inputCommandSMPort.interrupt();
     outputPortRecharge.interrupt();
-    outputPortObjectToActAt.interrupt();
-    outputMovementRAPort.interrupt();
-    outputMovementLAPort.interrupt();
-    outputMovementTPort.interrupt();
+    are.interrupt();
+    expression.interrupt();
     outputSpeechPort.interrupt();
-    outputEmotionsPort.interrupt();
-    outRpcEyelids_berry.interrupt();
-    outRpcEyelids_reddy.interrupt();
     outputPortEyelids_icub.interrupt();
+    outputDonePort.interrupt();
+    speechStatusPort.interrupt();
+
+    for(int p = 0; p < NUMBER_OF_PRIORITIES; p++){
+        if(channels[p] != nullptr){
+            channels[p]->stop();
+            delete channels[p];
+            channels[p] = nullptr;
+        }
+    }
 
     inputCommandSMPort.close();
     outputPortRecharge.close();
-    outputPortObjectToActAt.close();
-    outputMovementRAPort.close();
-    outputMovementLAPort.close();
-    outputMovementTPort.close();
+    are.stop();
+    are.close();
+    gaze.close();
+    inputTouchReflexPort.close();
+    outputReflexPort.close();
+    expression.close();
     outputSpeechPort.close();
-    outputEmotionsPort.close();
-    outRpcEyelids_berry.close();
-    outRpcEyelids_reddy.close();
     outputPortEyelids_icub.close();
+    outputDonePort.close();
+    speechStatusPort.close();
 }
 
 /*
@@ -0,0 +1,99 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file areClient.cpp
+ * @brief Implementation of the ARE client (see areClient.h).
+ */
+
+#include "iCub/areClient.h"
+#include <iostream>
+
+using namespace yarp::os;
+using namespace std;
+
+areClient::areClient(){
+    busy = false;
+}
+
+bool areClient::open(const string& name){
+    return port.open(name);
+}
+
+int areClient::getOutputCount(){
+    return port.getOutputCount();
+}
+
+future<Bottle> areClient::send(const Bottle& command){
+    areRequest request;
+    request.command = command;
+    request.reply = make_shared<promise<Bottle>>();
+    future<Bottle> reply = request.reply->get_future();
+
+    lock_guard<mutex> lock(requestsMutex);
+    requests.push_back(request);
+    requestsChanged.notify_all();
+    return reply;
+}
+
+bool areClient::isBusy(){
+    lock_guard<mutex> lock(requestsMutex);
+    return busy || !requests.empty();
+}
+
+void areClient::run(){
+    unique_lock<mutex> lock(requestsMutex);
+
+    while(!isStopping()){
+        requestsChanged.wait(lock, [this]{ return !requests.empty() || isStopping(); });
+        if(isStopping())
+            break;
+
+        areRequest request = requests.front();
+        requests.pop_front();
+        busy = true;
+        lock.unlock();
+
+        Bottle reply;
+        if(port.getOutputCount())
+            port.write(request.command, reply);
+        cout << "Reply ARE: " << reply.toString() << endl;
+        request.reply->set_value(reply);
+
+        lock.lock();
+        busy = false;
+    }
+
+    //nobody waits forever for the requests not sent
+    for(int i = 0; i < requests.size(); i++)
+        requests[i].reply->set_value(Bottle());
+    requests.clear();
+}
+
+void areClient::onStop(){
+    port.interrupt();
+    lock_guard<mutex> lock(requestsMutex);
+    requestsChanged.notify_all();
+}
+
+void areClient::interrupt(){
+    port.interrupt();
+}
+
+void areClient::close(){
+    port.close();
+}
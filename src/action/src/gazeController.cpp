@@ -0,0 +1,266 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file gazeController.cpp
+ * @brief Implementation of the gaze controller (see gazeController.h).
+ */
+
+#include "iCub/gazeController.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::sig;
+using namespace std;
+
+gazeController::gazeController(double period):PeriodicThread(period){
+    iGaze = nullptr;
+    gazeMutex = nullptr;
+    speed = GAZE_DEFAULT_SPEED;
+    minDwell = 3.0;
+    maxDwell = 5.0;
+    faceDistance = 1.0;
+
+    mode = GAZE_MODE_IDLE;
+    setpoint.azimuth = setpoint.elevation = 0.0;
+    goal = setpoint;
+    lastRun = 0.0;
+    scanIndex = 0;
+    nextScan = 0.0;
+    lastFace = 0.0;
+    settled = true;
+
+    resumeMode = GAZE_MODE_IDLE;
+    resumeGoal = goal;
+    reflexEnd = 0.0;
+}
+
+bool gazeController::configure(const Bottle& variables){
+    setPeriod(variables.check("GAZE_STREAM_PERIOD", Value(GAZE_DEFAULT_PERIOD)).asFloat64());
+    speed = variables.check("GAZE_PURSUIT_SPEED", Value(GAZE_DEFAULT_SPEED)).asFloat64();
+    rng.seed(variables.check("GAZE_SEED", Value(7)).asInt32());
+
+    Bottle* targetsList = variables.find("GAZE_TARGETS").asList();
+    if(targetsList == nullptr || targetsList->size() == 0){
+        yError("GAZE_TARGETS ((name azimuth elevation) ...) is needed by the gaze");
+        return false;
+    }
+    targets.clear();
+    for(int i = 0; i < targetsList->size(); i++){
+        Bottle* target = targetsList->get(i).asList();
+        if(target == nullptr || target->size() != 3){
+            yError("Each target in GAZE_TARGETS must be (name azimuth elevation)");
+            return false;
+        }
+        gazeTarget angles;
+        angles.azimuth = target->get(1).asFloat64();
+        angles.elevation = target->get(2).asFloat64();
+        targets[target->get(0).asString()] = angles;
+    }
+
+    scanTargets.clear();
+    Bottle* scanList = variables.find("GAZE_SCAN").asList();
+    if(scanList != nullptr)
+        for(int i = 0; i < scanList->size(); i++){
+            if(!hasTarget(scanList->get(i).asString())){
+                yError("Unknown target in GAZE_SCAN: %s", scanList->get(i).asString().c_str());
+                return false;
+            }
+            scanTargets.push_back(scanList->get(i).asString());
+        }
+
+    Bottle* dwellList = variables.find("GAZE_SCAN_DWELL").asList();
+    if(dwellList != nullptr && dwellList->size() == 2){
+        minDwell = dwellList->get(0).asFloat64();
+        maxDwell = dwellList->get(1).asFloat64();
+    }
+
+    return true;
+}
+
+bool gazeController::openPorts(const string& name){
+    if(!inputFacePort.open(name + "/face:i")){
+        yError("unable to open port to receive the face seen");
+        return false;
+    }
+    return true;
+}
+
+void gazeController::setGaze(IGazeControl* iGaze_, mutex* gazeMutex_){
+    iGaze = iGaze_;
+    gazeMutex = gazeMutex_;
+}
+
+bool gazeController::hasTarget(const string& name){
+    return targets.find(name) != targets.end();
+}
+
+//the pursuit starts where the head is (ARE or the pixel commands may have moved it)
+void gazeController::startFromCurrentAngles(){
+    if(mode != GAZE_MODE_IDLE && mode != GAZE_MODE_TRACK)
+        return;
+    Vector ang(3);
+    if(iGaze != nullptr && iGaze->getAngles(ang)){
+        setpoint.azimuth = ang[0];
+        setpoint.elevation = ang[1];
+    }
+    goal = setpoint;
+    lastRun = Time::now();
+}
+
+void gazeController::fixate(const string& name){
+    startFromCurrentAngles();
+    goal = targets[name];
+    settled = false;
+    mode = GAZE_MODE_FIXATE;
+}
+
+void gazeController::turn(double azimuth, double elevation){
+    startFromCurrentAngles();
+    goal.azimuth += azimuth;
+    goal.elevation += elevation;
+    settled = false;
+    mode = GAZE_MODE_FIXATE;
+}
+
+void gazeController::scan(){
+    if(mode == GAZE_MODE_SCAN || scanTargets.empty())
+        return;
+    startFromCurrentAngles();
+    scanIndex = 0;
+    nextScan = Time::now();
+    mode = GAZE_MODE_SCAN;
+}
+
+void gazeController::track(){
+    if(mode == GAZE_MODE_TRACK)
+        return;
+    startFromCurrentAngles();
+    lastFace = Time::now();
+    mode = GAZE_MODE_TRACK;
+}
+
+void gazeController::orient(const string& name, double hold){
+    if(mode != GAZE_MODE_REFLEX){
+        startFromCurrentAngles();
+        resumeMode = mode;
+        resumeGoal = goal;
+    }
+    goal = targets[name];
+    reflexEnd = Time::now() + hold;
+    mode = GAZE_MODE_REFLEX;
+}
+
+void gazeController::release(){
+    mode = GAZE_MODE_IDLE;
+    settled = true;
+}
+
+bool gazeController::isSettled(){
+    return mode != GAZE_MODE_FIXATE || settled;
+}
+
+void gazeController::sendSetpoint(){
+    Vector ang(3);
+    ang[0] = setpoint.azimuth;
+    ang[1] = setpoint.elevation;
+    ang[2] = 0.0;
+    iGaze->lookAtAbsAngles(ang);
+}
+
+void gazeController::readFace(){
+    Bottle* face = inputFacePort.read(false);
+    if(face == nullptr || face->size() < 4 || !face->get(3).asInt16())
+        return;
+
+    Vector px(2);
+    px[0] = face->get(1).asFloat64();
+    px[1] = face->get(2).asFloat64();
+    iGaze->lookAtMonoPixel(0, px, faceDistance);
+    lastFace = Time::now();
+}
+
+void gazeController::run(){
+    if(gazeMutex == nullptr)
+        return;
+    lock_guard<mutex> lock(*gazeMutex);
+    if(iGaze == nullptr || mode == GAZE_MODE_IDLE)
+        return;
+
+    //a late cycle moves the setpoint at most two periods, so the jitter does not become a jump of the head
+    double now = Time::now();
+    double dt = min(max(now - lastRun, 0.0), 2.0 * getPeriod());
+    lastRun = now;
+
+    if(mode == GAZE_MODE_TRACK){
+        readFace();
+        if(now - lastFace < GAZE_TRACK_TIMEOUT)
+            return;
+        //face lost, back home
+        startFromCurrentAngles();
+        goal = targets.count("home") ? targets["home"] : goal;
+        settled = false;
+        mode = GAZE_MODE_FIXATE;
+    }
+
+    if(mode == GAZE_MODE_REFLEX && now >= reflexEnd){
+        //back to the previous mode, from idle the head goes back where it was
+        mode = resumeMode;
+        goal = resumeGoal;
+        settled = false;
+        if(mode == GAZE_MODE_IDLE)
+            mode = GAZE_MODE_FIXATE;
+        else if(mode == GAZE_MODE_TRACK)
+            lastFace = now;
+        else if(mode == GAZE_MODE_SCAN)
+            nextScan = now;
+    }
+
+    if(mode == GAZE_MODE_SCAN && now >= nextScan && (setpoint.azimuth == goal.azimuth && setpoint.elevation == goal.elevation)){
+        goal = targets[scanTargets[scanIndex]];
+        scanIndex = (scanIndex + 1) % scanTargets.size();
+        uniform_real_distribution<double> distrDwell(minDwell, maxDwell);
+        nextScan = now + distrDwell(rng);
+    }
+
+    double errorAzimuth = goal.azimuth - setpoint.azimuth;
+    double errorElevation = goal.elevation - setpoint.elevation;
+    double error = sqrt(errorAzimuth * errorAzimuth + errorElevation * errorElevation);
+    if(error == 0.0)
+        return;
+
+    double step = speed * dt;
+    if(error <= step){
+        setpoint = goal;
+    }else{
+        setpoint.azimuth += errorAzimuth * step / error;
+        setpoint.elevation += errorElevation * step / error;
+    }
+    settled = error <= step;
+    sendSetpoint();
+}
+
+void gazeController::interrupt(){
+    inputFacePort.interrupt();
+}
+
+void gazeController::close(){
+    inputFacePort.close();
+}
@@ -0,0 +1,72 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file batteryBank.h
+ * @brief Simulated batteries of several robots, advanced together at each tick.
+ */
+
+#ifndef _BATTERYBANK_H_
+#define _BATTERYBANK_H_
+
+#include <vector>
+
+#include "iCub/batteryModel.h"
+
+/*  K simulated batteries (one for each simulated robot) stored as structure-of-arrays.
+    All the batteries share the limits and the recharge, and are advanced together in one pass per tick
+    (batteryModel::stepLevel, the same of batteryModel::step, has no branches so the compiler can vectorize the loop).
+*/
+class batteryBank{
+    private:
+        std::vector<double> level;
+        std::vector<double> decreaseRate;   //consumption per tick of the behavior each robot is executing
+        std::vector<double> rechargeTicks;  //ticks of recharge remaining (double to be in the same loop of the levels)
+
+        double minLevel;
+        double maxLevel;
+        double valueToRecharge;
+        int rechargeTime;
+        double period;
+
+    public:
+        batteryBank();
+        ~batteryBank();
+
+        void init(int instances, double minLevel_, double maxLevel_, double valueToRecharge_, int rechargeTime_, double period_);
+        int size();
+
+        void setLevel(int instance, double newLevel);
+        double getLevel(int instance);
+        void setDecreaseRate(int instance, double rate);
+        double getDecreaseRate(int instance);
+        int getRechargeTicks(int instance);
+        void startRecharge(int instance);
+        bool isEmpty(int instance);
+
+        /**
+        * advance all the batteries by one tick
+        */
+        void step();
+
+        /**
+        * copy of the state of one battery, used for the closed form predictions
+        */
+        batteryModel getModel(int instance);
+};
+
+#endif  //_BATTERYBANK_H_
@@ -0,0 +1,98 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file batteryModel.h
+ * @brief Simulated battery: dynamics of each tick and closed form predictions of the level.
+ */
+
+#ifndef _BATTERYMODEL_H_
+#define _BATTERYMODEL_H_
+
+#include <algorithm>
+
+#define NEVER_REACHED -1    //returned by the predictions when the level is never reached with the current rates
+
+/*  Battery dynamics at each tick (same as the original batterySensorThread::run):
+        level -= decreaseRate
+        if recharging: level = min(level + VALUE_TO_RECHARGE/rechargeTime, max) for rechargeTime ticks
+        if level <= min: level = min
+    With constant rates the level is piecewise linear (recharge phase, then discharge phase),
+    so the level at any future tick and the time to reach a level are computed in closed form.
+*/
+class batteryModel{
+    private:
+        double level;
+        double minLevel;
+        double maxLevel;
+        double decreaseRate;        //consumption per tick of the behavior being executed
+        double rechargePerTick;     //VALUE_TO_RECHARGE / rechargeTime
+        int rechargeTime;           //ticks needed for each recharge
+        int rechargeTicks;          //ticks of recharge remaining
+        double period;              //s of each tick
+
+        int ticksToReach(double from, double to, double slope);
+
+    public:
+        batteryModel();
+        ~batteryModel();
+
+        /**
+        * level after one tick (recharging 1.0 or 0.0), without branches: shared with the vectorized loop of batteryBank
+        */
+        static double stepLevel(double level, double decreaseRate, double recharging, double rechargePerTick, double minLevel, double maxLevel){
+            double newLevel = level - decreaseRate + recharging * rechargePerTick;
+            //the max level is applied just when recharging
+            newLevel = recharging * std::min(newLevel, maxLevel) + (1.0 - recharging) * newLevel;
+            return std::max(newLevel, minLevel);
+        }
+
+        void init(double minLevel_, double maxLevel_, double valueToRecharge, int rechargeTime_, double period_);
+
+        void setLevel(double newLevel);
+        double getLevel();
+        void setDecreaseRate(double rate);
+        double getDecreaseRate();
+        int getRechargeTicks();
+        void setRechargeTicks(int ticks);
+        void startRecharge();
+        bool isEmpty();
+
+        /**
+        * advance the battery by one tick
+        */
+        void step();
+
+        /**
+        * level after a number of ticks, without changing the battery
+        */
+        double levelAfterTicks(int ticks);
+
+        /**
+        * ticks until the level crosses target (0 if it is already there), NEVER_REACHED otherwise
+        */
+        int ticksToLevel(double target);
+
+        /**
+        * same as the functions above, but in seconds
+        */
+        double levelAt(double t);
+        double timeToLevel(double target);
+        double timeToEmpty();
+};
+
+#endif  //_BATTERYMODEL_H_
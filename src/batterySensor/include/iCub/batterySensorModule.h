@@ -49,7 +49,7 @@ class batterySensorModule:public yarp::os::RFModule {
     
     yarp::os::Port handlerPort;              // a port to handle messages 
     /*  */
-    batterySensorThread *pThread;             // pointer to a new thread to be created and started in configure() and stopped in close()
+    batterySensorThread *pThread = nullptr; // pointer to a new thread to be created and started in configure() and stopped in close()
 
 public:
     /**
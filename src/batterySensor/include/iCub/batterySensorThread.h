@@ -35,6 +35,12 @@
 #include <fstream>
 #include <time.h>
 #include <random>
+#include <mutex>
+#include <memory>
+
+#include "iCub/batteryModel.h"
+#include "iCub/batteryBank.h"
+#include "iCub/monitoredThread.h"
 
 //Used to initialize the variables
 #define LEARNING_PHASE      "learn"
@@ -42,7 +48,7 @@
 #define FINETUNING_PHASE    "finetuning"
 #define RULE_BASED          "rulebased"
 
-class batterySensorThread : public yarp::os::PeriodicThread {
+class batterySensorThread : public monitoredThread {
 private:
 
     std::string robot;              // name of the robot
@@ -61,16 +67,18 @@ private:
     std::string timeNow;
     std::time_t timeInitial;
 
-    double batteryLevel;
-    double decreaseRate;
+    //One battery for each simulated robot (instances 1 is the default, a single robot with the original port names)
+    int instances;
+    batteryBank batteries;
+    std::mutex batteryMutex;        //the predictions are requested by the RPC port (module thread)
     const int rechargeTime = 10; 
-    int rechargeTime_remaining;
 
     //-------------------------Values are defined in the configuration file
     double VALUE_TO_RECHARGE;
     double MIN_BATTERY_LEVEL;
     double MAX_BATTERY_LEVEL;
     double SURVIVAL_HOMEOSTASIS;
+    double SURVIVAL_LOWERBOUND;     //below this level the survival drive is active
     double PERCEN_HOMEOSTASIS;
     int RANGE_SURVIVE;
     
@@ -88,12 +96,17 @@ private:
 
     std::mt19937 rdx{static_cast<long unsigned int>(21)};
     
-    yarp::os::BufferedPort<yarp::os::Bottle> inputPortRecharge;             //if action is "recharge" receives info here to update the battery level
-    yarp::os::BufferedPort<yarp::os::Bottle> inputUpdBatteryConsPort;       //battery consumption is according to the behavior to be executed
-    yarp::os::BufferedPort<yarp::os::Bottle> inputPortResetBattery;        //reset battery level when the episode finishes in RL
+    //Ports of each battery instance: <name>/<instance>/... when there is more than one instance
+    typedef struct batteryPorts_{
+        yarp::os::BufferedPort<yarp::os::Bottle> inputPortRecharge;             //if action is "recharge" receives info here to update the battery level
+        yarp::os::BufferedPort<yarp::os::Bottle> inputUpdBatteryConsPort;       //battery consumption is according to the behavior to be executed
+        yarp::os::BufferedPort<yarp::os::Bottle> inputPortResetBattery;        //reset battery level when the episode finishes in RL
+
+        yarp::os::BufferedPort<yarp::os::Bottle> outputPortBatteryLevel;
+        yarp::os::BufferedPort<yarp::os::Bottle> outputPortNoBattery;
+    }batteryPorts;
 
-    yarp::os::BufferedPort<yarp::os::Bottle> outputPortBatteryLevel;
-    yarp::os::BufferedPort<yarp::os::Bottle> outputPortNoBattery;
+    std::vector<std::unique_ptr<batteryPorts>> ports;
 
 public:
     /**
@@ -125,7 +138,7 @@ public:
     /**
     *  active part of the thread
     */
-    void run(); 
+    void tick() override;
 
     /**
     * function that sets the rootname of all the ports that are going to be created by the thread
@@ -140,6 +153,11 @@ public:
     */
     std::string getName(const char* p);
 
+    /**
+    * name of a port of one battery instance (same as getName when there is just one instance)
+    */
+    std::string getInstanceName(int instance, const char* p);
+
     /**
     * function that sets the inputPort name
     */
@@ -150,15 +168,34 @@ public:
      **/
     bool processing();
     bool openAllPorts();
-    double recharge();
-    bool noBattery();
-    void updateDecreaseRate(std::string behavior);
-    void resetBattery();
+    void closeAllPorts();
+    bool noBattery(int instance);
+    void updateDecreaseRate(int instance, std::string behavior);
+    void resetBattery(int instance);
+    void readInstancePorts(int instance);
+    void writeInstancePorts(int instance);
     void initVarsFromFile();
     void printData();
 
     void saveData();
     void saveHeaders();
+
+    /**
+    * battery level t seconds from now with the current decrease rate and recharge
+    */
+    double predictLevel(double t, int instance = 0);
+
+    /**
+    * time (s) until the battery is empty, NEVER_REACHED if it does not happen with the current rates
+    */
+    double predictTimeToEmpty(int instance = 0);
+
+    /**
+    * time (s) until the battery reaches the lowerbound of the homeostasis (from above when consuming, from below when recharging)
+    */
+    double predictTimeToHomeostasis(int instance = 0);
+
+    int getInstances();
 };
 
 #endif  //_BATTERYSENSOR_PERIODTHREAD_H_
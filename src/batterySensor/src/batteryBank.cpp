@@ -0,0 +1,104 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file batteryBank.cpp
+ * @brief Implementation of the battery bank (see batteryBank.h).
+ */
+
+#include "iCub/batteryBank.h"
+#include <algorithm>
+
+using namespace std;
+
+batteryBank::batteryBank(){
+    minLevel = 0.0;
+    maxLevel = 100.0;
+    valueToRecharge = 0.0;
+    rechargeTime = 1;
+    period = 1.0;
+}
+
+batteryBank::~batteryBank(){
+}
+
+void batteryBank::init(int instances, double minLevel_, double maxLevel_, double valueToRecharge_, int rechargeTime_, double period_){
+    minLevel = minLevel_;
+    maxLevel = maxLevel_;
+    valueToRecharge = valueToRecharge_;
+    rechargeTime = rechargeTime_;
+    period = period_;
+
+    level.assign(instances, maxLevel);
+    decreaseRate.assign(instances, 0.0);
+    rechargeTicks.assign(instances, 0.0);
+}
+
+int batteryBank::size(){
+    return level.size();
+}
+
+void batteryBank::setLevel(int instance, double newLevel){
+    level[instance] = newLevel;
+}
+
+double batteryBank::getLevel(int instance){
+    return level[instance];
+}
+
+void batteryBank::setDecreaseRate(int instance, double rate){
+    decreaseRate[instance] = rate;
+}
+
+double batteryBank::getDecreaseRate(int instance){
+    return decreaseRate[instance];
+}
+
+int batteryBank::getRechargeTicks(int instance){
+    return (int)rechargeTicks[instance];
+}
+
+void batteryBank::startRecharge(int instance){
+    rechargeTicks[instance] += rechargeTime;
+}
+
+bool batteryBank::isEmpty(int instance){
+    return level[instance] <= minLevel;
+}
+
+void batteryBank::step(){
+    const int n = level.size();
+    const double rechargePerTick = valueToRecharge / rechargeTime;
+    const double lo = minLevel, hi = maxLevel;
+    double *l = level.data(), *r = rechargeTicks.data();
+    const double *c = decreaseRate.data();
+
+    for(int i = 0; i < n; i++){
+        double recharging = r[i] > 0.0 ? 1.0 : 0.0;
+        l[i] = batteryModel::stepLevel(l[i], c[i], recharging, rechargePerTick, lo, hi);
+        r[i] -= recharging;
+    }
+}
+
+batteryModel batteryBank::getModel(int instance){
+    batteryModel model;
+    model.init(minLevel, maxLevel, valueToRecharge, rechargeTime, period);
+    model.setLevel(level[instance]);
+    model.setDecreaseRate(decreaseRate[instance]);
+    model.setRechargeTicks(getRechargeTicks(instance));
+    return model;
+}
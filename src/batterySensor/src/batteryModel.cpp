@@ -0,0 +1,145 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file batteryModel.cpp
+ * @brief Implementation of the battery model (see batteryModel.h).
+ */
+
+#include "iCub/batteryModel.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+#define EPSILON 1e-9    //to not count one tick more because of rounding errors
+
+batteryModel::batteryModel(){
+    level = 0.0;
+    minLevel = 0.0;
+    maxLevel = 100.0;
+    decreaseRate = 0.0;
+    rechargePerTick = 0.0;
+    rechargeTime = 1;
+    rechargeTicks = 0;
+    period = 1.0;
+}
+
+batteryModel::~batteryModel(){
+}
+
+void batteryModel::init(double minLevel_, double maxLevel_, double valueToRecharge, int rechargeTime_, double period_){
+    minLevel = minLevel_;
+    maxLevel = maxLevel_;
+    rechargeTime = rechargeTime_;
+    rechargePerTick = valueToRecharge / rechargeTime;
+    rechargeTicks = 0;
+    period = period_;
+}
+
+void batteryModel::setLevel(double newLevel){
+    level = newLevel;
+}
+
+double batteryModel::getLevel(){
+    return level;
+}
+
+void batteryModel::setDecreaseRate(double rate){
+    decreaseRate = rate;
+}
+
+double batteryModel::getDecreaseRate(){
+    return decreaseRate;
+}
+
+int batteryModel::getRechargeTicks(){
+    return rechargeTicks;
+}
+
+void batteryModel::setRechargeTicks(int ticks){
+    rechargeTicks = ticks;
+}
+
+void batteryModel::startRecharge(){
+    rechargeTicks += rechargeTime;
+}
+
+bool batteryModel::isEmpty(){
+    return level <= minLevel;
+}
+
+void batteryModel::step(){
+    double recharging = rechargeTicks > 0 ? 1.0 : 0.0;
+    level = stepLevel(level, decreaseRate, recharging, rechargePerTick, minLevel, maxLevel);
+    if(rechargeTicks > 0)
+        rechargeTicks--;
+}
+
+double batteryModel::levelAfterTicks(int ticks){
+    if(ticks <= 0)
+        return level;
+
+    //recharge phase: the level changes (rechargePerTick - decreaseRate) per tick, bounded by max (recharging) or min (consuming)
+    int rechargePhase = min(ticks, rechargeTicks);
+    double newLevel = level + rechargePhase * (rechargePerTick - decreaseRate);
+    if(rechargePhase > 0)
+        newLevel = min(newLevel, maxLevel);
+
+    //discharge phase: just the consumption of the behavior
+    newLevel -= (ticks - rechargePhase) * decreaseRate;
+
+    return max(newLevel, minLevel);
+}
+
+//Ticks to go from "from" to "to" changing "slope" per tick
+int batteryModel::ticksToReach(double from, double to, double slope){
+    if(from == to)
+        return 0;
+    if((to - from) * slope <= 0)//going to the other direction (or not changing)
+        return NEVER_REACHED;
+    return (int)ceil((to - from) / slope - EPSILON);
+}
+
+int batteryModel::ticksToLevel(double target){
+    if(target < minLevel || target > maxLevel)
+        return NEVER_REACHED;
+
+    int ticks = ticksToReach(level, target, rechargePerTick - decreaseRate);
+    if(rechargeTicks > 0 && ticks != NEVER_REACHED && ticks <= rechargeTicks)
+        return ticks;
+
+    ticks = ticksToReach(levelAfterTicks(rechargeTicks), target, -decreaseRate);
+    if(ticks == NEVER_REACHED)
+        return NEVER_REACHED;
+    return rechargeTicks + ticks;
+}
+
+double batteryModel::levelAt(double t){
+    return levelAfterTicks((int)floor(t / period + EPSILON));
+}
+
+double batteryModel::timeToLevel(double target){
+    int ticks = ticksToLevel(target);
+    if(ticks == NEVER_REACHED)
+        return NEVER_REACHED;
+    return ticks * period;
+}
+
+double batteryModel::timeToEmpty(){
+    return timeToLevel(minLevel);
+}
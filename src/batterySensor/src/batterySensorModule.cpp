@@ -118,7 +118,13 @@ bool batterySensorModule::respond(const Bottle& command, Bottle& reply)
     string helpMessage =  string(getName().c_str()) + 
                 " commands are: \n" +  
                 "help \n" +
-                "quit \n";
+                "ready : ok when the module is running (connections done), wait before \n" +
+                "period : period ticks overruns meanUsed maxUsed jitter (s) of the thread \n" +
+                "quit \n" +
+                "level <t> [instance] : battery level t seconds from now \n" +
+                "empty [instance] : time (s) until the battery is empty (-1 if never) \n" +
+                "homeostasis [instance] : time (s) until the battery reaches the lowerbound of the homeostasis (-1 if never) \n" +
+                "instances : number of simulated batteries \n";
     reply.clear(); 
 
     if (command.get(0).asString()=="quit") {
@@ -131,6 +137,31 @@ bool batterySensorModule::respond(const Bottle& command, Bottle& reply)
         cout << helpMessage;
         reply.addString("ok");
     }
+    else if (command.get(0).asString()=="ready") {
+        reply.addString(pThread != nullptr && pThread->isRunning() ? "ok" : "wait");
+    }
+    else if (command.get(0).asString()=="period" && pThread != nullptr) {
+        pThread->addPeriodStats(reply);
+    }
+    else if (command.get(0).asString()=="instances") {
+        reply.addInt32(pThread->getInstances());
+    }
+    else if (command.get(0).asString()=="level" || command.get(0).asString()=="empty" || command.get(0).asString()=="homeostasis") {
+        //the instance is the last (optional) argument
+        int instance = 0;
+        int instancePosition = command.get(0).asString()=="level" ? 2 : 1;
+        if (command.size() > instancePosition)
+            instance = command.get(instancePosition).asInt32();
+
+        if (instance < 0 || instance >= pThread->getInstances())
+            reply.addString("invalid instance");
+        else if (command.get(0).asString()=="level")
+            reply.addFloat64(pThread->predictLevel(command.get(1).asFloat64(), instance));
+        else if (command.get(0).asString()=="empty")
+            reply.addFloat64(pThread->predictTimeToEmpty(instance));
+        else
+            reply.addFloat64(pThread->predictTimeToHomeostasis(instance));
+    }
     
     return true;
 }
@@ -37,13 +37,15 @@ using namespace boost;
 #define THPERIOD 0.5 //s
 #define NON_EXIST -1 //Must be the same value defined in objectPerception module
 
-batterySensorThread::batterySensorThread():PeriodicThread(THPERIOD) {
+batterySensorThread::batterySensorThread():monitoredThread(THPERIOD) {
     robot = "icub";        
+    instances = 1;
 }
 
-batterySensorThread::batterySensorThread(string robotname, ResourceFinder &_rf):PeriodicThread(THPERIOD){
+batterySensorThread::batterySensorThread(string robotname, ResourceFinder &_rf):monitoredThread(THPERIOD){
     robot = robotname;
     rf = _rf;
+    instances = 1;
 }
 
 batterySensorThread::~batterySensorThread() {
@@ -65,53 +67,71 @@ void batterySensorThread::setInputPortName(string InpPort) {
     
 }
 
-bool batterySensorThread::openAllPorts(){
-    if(!inputPortRecharge.open(getName("/recharge:i").c_str())){
-        yError("unable to open port to send unmasked events ");
-        return false;
-    }
-
-    if(!inputUpdBatteryConsPort.open(getName("/updateBatteryConsumption:i").c_str())){
-        yError("unable to open port to send unmasked events ");
-        return false;
-    }
-
-    if(!inputPortResetBattery.open(getName("/resetBattery:i").c_str())){
-        yError("unable to open port to send unmasked events ");
-        return false;
-    }
-
-    if(!outputPortBatteryLevel.open(getName("/batteryLevel:o").c_str())){
-        yError("unable to open port");
-        return false;  // unable to open; let RFModule know so that it won't run
-    }
+std::string batterySensorThread::getInstanceName(int instance, const char* p) {
+    if(instances == 1)
+        return getName(p);
+    return getName(("/" + to_string(instance) + p).c_str());
+}
 
-    if(!outputPortNoBattery.open(getName("/noBattery:o").c_str())){
-        yError("unable to open port");
-        return false;  // unable to open; let RFModule know so that it won't run
+bool batterySensorThread::openAllPorts(){
+    for(int i = 0; i < instances; i++){
+        ports.push_back(std::unique_ptr<batteryPorts>(new batteryPorts));
+
+        if(!ports[i]->inputPortRecharge.open(getInstanceName(i, "/recharge:i").c_str())){
+            yError("unable to open port to send unmasked events ");
+            return false;
+        }
+
+        if(!ports[i]->inputUpdBatteryConsPort.open(getInstanceName(i, "/updateBatteryConsumption:i").c_str())){
+            yError("unable to open port to send unmasked events ");
+            return false;
+        }
+
+        if(!ports[i]->inputPortResetBattery.open(getInstanceName(i, "/resetBattery:i").c_str())){
+            yError("unable to open port to send unmasked events ");
+            return false;
+        }
+
+        if(!ports[i]->outputPortBatteryLevel.open(getInstanceName(i, "/batteryLevel:o").c_str())){
+            yError("unable to open port");
+            return false;  // unable to open; let RFModule know so that it won't run
+        }
+
+        if(!ports[i]->outputPortNoBattery.open(getInstanceName(i, "/noBattery:o").c_str())){
+            yError("unable to open port");
+            return false;  // unable to open; let RFModule know so that it won't run
+        }
     }
     
     return true;
 }
 
 bool batterySensorThread::threadInit() {
+    configurePeriod(rf.findGroup("periods"), "batterySensor");
+
     filepath = rf.find("filepath").asString();
     filename = filepath + filename;
+
+    instances = max(1, rf.check("instances", Value(1)).asInt32());
     
     saveHeaders();
 
     initVarsFromFile();
 
     SURVIVAL_HOMEOSTASIS = PERCEN_HOMEOSTASIS * (MAX_BATTERY_LEVEL - MIN_BATTERY_LEVEL) + MIN_BATTERY_LEVEL + RANGE_SURVIVE;//Upperbound homeostasis
+    SURVIVAL_LOWERBOUND = SURVIVAL_HOMEOSTASIS - 2 * RANGE_SURVIVE;
 
-    resetBattery();
+    batteries.init(instances, MIN_BATTERY_LEVEL, MAX_BATTERY_LEVEL, VALUE_TO_RECHARGE, rechargeTime, getPeriod());
 
-    printData();
+    for(int i = 0; i < instances; i++)
+        resetBattery(i);
 
-    rechargeTime_remaining = 0;
+    printData();
 
-    if(!openAllPorts())
+    if(!openAllPorts()){
+        closeAllPorts();
         return false;
+    }
 
     yInfo("Initialization of the processing thread correctly ended");
 
@@ -125,14 +145,23 @@ void batterySensorThread::saveHeaders(){
     ofstream fout; 
     
     fout.open(filename, ios::app);
-    fout << fileHeader << "\n";
+    if(instances == 1)
+        fout << fileHeader << "\n";
+    else{//one column for each battery instance
+        fout << "time,durationExp";
+        for(int i = 0; i < instances; i++)
+            fout << ",batteryLevel_" << i;
+        fout << "\n";
+    }
     fout.close( );
 }
 
 void batterySensorThread::saveData(){
     ofstream fout;
     fout.open(filename, ios::app);
-    fout << timeNow << ',' << to_string(Time::now() - timeInitial) << ',' << batteryLevel;
+    fout << timeNow << ',' << to_string(Time::now() - timeInitial);
+    for(int i = 0; i < instances; i++)
+        fout << ',' << batteries.getLevel(i);
     fout <<"\n";
     fout.close();
 }
@@ -153,7 +182,8 @@ void batterySensorThread::printData(){
     cout<<"RECHARGE_CONS: "<<RECHARGE_CONS<<endl;
     cout<<"INTERACT_CONS: "<<INTERACT_CONS<<endl;
 
-    cout<<"Initial batteryLevel: "<<batteryLevel<<endl;
+    cout<<"instances: "<<instances<<endl;
+    cout<<"Initial batteryLevel: "<<batteries.getLevel(0)<<endl;
 }
 
 void batterySensorThread::initVarsFromFile(){
@@ -182,104 +212,125 @@ void batterySensorThread::initVarsFromFile(){
         mode = RULE_BASED;
 }
 
-void batterySensorThread::resetBattery(){
-    cout<<"Reset battery"<<endl;
-    decreaseRate = INIT_END_CONS;
+void batterySensorThread::resetBattery(int instance){
+    cout<<"Reset battery "<<instance<<endl;
+    batteries.setDecreaseRate(instance, INIT_END_CONS);
 
     if(mode.compare(LEARNING_PHASE) == 0 || mode.compare(FINETUNING_PHASE) == 0){
         std::uniform_real_distribution<double> dist(MIN_BATTERY_LEVEL, MAX_BATTERY_LEVEL);
-        batteryLevel = dist(rdx);
+        batteries.setLevel(instance, dist(rdx));
     }else if(mode.compare(TESTING_PHASE) == 0)
-        batteryLevel = SURVIVAL_HOMEOSTASIS;
+        batteries.setLevel(instance, SURVIVAL_HOMEOSTASIS);
     else
-        batteryLevel = rf.findGroup("variables").check("INIT_BATTERY", Value(MAX_BATTERY_LEVEL)).asFloat64();;
+        batteries.setLevel(instance, rf.findGroup("variables").check("INIT_BATTERY", Value(MAX_BATTERY_LEVEL)).asFloat64());
+}
+
+bool batterySensorThread::noBattery(int instance){
+    return batteries.isEmpty(instance);
+}
+
+int batterySensorThread::getInstances(){
+    return instances;
 }
 
-double batterySensorThread::recharge(){
-    cout<<"Recharge " << batteryLevel + VALUE_TO_RECHARGE << endl;
-    return(min(batteryLevel + (VALUE_TO_RECHARGE/rechargeTime), MAX_BATTERY_LEVEL));
+double batterySensorThread::predictLevel(double t, int instance){
+    lock_guard<mutex> lock(batteryMutex);
+    return batteries.getModel(instance).levelAt(t);
 }
 
-bool batterySensorThread::noBattery(){
-    if(batteryLevel <= MIN_BATTERY_LEVEL)
-        return true;
-    return false;
+double batterySensorThread::predictTimeToEmpty(int instance){
+    lock_guard<mutex> lock(batteryMutex);
+    return batteries.getModel(instance).timeToEmpty();
 }
 
-void batterySensorThread::updateDecreaseRate(string behavior){
+double batterySensorThread::predictTimeToHomeostasis(int instance){
+    lock_guard<mutex> lock(batteryMutex);
+    return batteries.getModel(instance).timeToLevel(SURVIVAL_LOWERBOUND);
+}
+
+void batterySensorThread::updateDecreaseRate(int instance, string behavior){
     if(behavior.compare("initial") == 0 || behavior.compare("end") == 0)
-        decreaseRate = INIT_END_CONS;
+        batteries.setDecreaseRate(instance, INIT_END_CONS);
     else if(behavior.compare("idle") == 0)
-        decreaseRate = IDLE_CONS;
+        batteries.setDecreaseRate(instance, IDLE_CONS);
     else if(behavior.compare("play") == 0)
-        decreaseRate = PLAY_CONS;
+        batteries.setDecreaseRate(instance, PLAY_CONS);
     else if(behavior.compare("recharge") == 0)
-        decreaseRate = RECHARGE_CONS;
+        batteries.setDecreaseRate(instance, RECHARGE_CONS);
     else if(behavior.compare("interact") == 0)
-        decreaseRate = INTERACT_CONS;
+        batteries.setDecreaseRate(instance, INTERACT_CONS);
     else if(behavior.compare("lookDown") == 0)
-        decreaseRate = LOOKDOWN_CONS;
+        batteries.setDecreaseRate(instance, LOOKDOWN_CONS);
 }
 
-void batterySensorThread::run() {
-    now = time(0);
-    char* timeNow_ = ctime(&now);
-    timeNow = timeNow_;
-    erase_all(timeNow, "\n");
+void batterySensorThread::readInstancePorts(int instance){
+    batteryPorts* p = ports[instance].get();
 
     //reset battery level when the episode finishes in RL. Could reset when noBattery() is true, but then could lose control of the data timing in DM
-    if(inputPortResetBattery.getInputCount()){
-        Bottle* readR = inputPortResetBattery.read(false);
+    if(p->inputPortResetBattery.getInputCount()){
+        Bottle* readR = p->inputPortResetBattery.read(false);
         if(readR != nullptr)
-            resetBattery();
+            resetBattery(instance);
     }
 
     //the decrease rate is according to the activity executed (defined in the decision making module)
-    if(inputUpdBatteryConsPort.getInputCount()){
-        Bottle* behavior = inputUpdBatteryConsPort.read(false);
+    if(p->inputUpdBatteryConsPort.getInputCount()){
+        Bottle* behavior = p->inputUpdBatteryConsPort.read(false);
         if(behavior != nullptr)
-            updateDecreaseRate(behavior->get(0).asString());
+            updateDecreaseRate(instance, behavior->get(0).asString());
     }
-    
-    cout<<"decreaseRate: "<<decreaseRate<<endl;
-    batteryLevel -= decreaseRate;
 
-    if(inputPortRecharge.getInputCount()){
+    if(p->inputPortRecharge.getInputCount()){
         Bottle* readD = nullptr;
-        readD = inputPortRecharge.read(false);
+        readD = p->inputPortRecharge.read(false);
         if(readD != nullptr)
-            rechargeTime_remaining += rechargeTime;
-            //batteryLevel = recharge();      
+            batteries.startRecharge(instance);
+    }
+}
+
+void batterySensorThread::writeInstancePorts(int instance){
+    batteryPorts* p = ports[instance].get();
+
+    if(p->outputPortBatteryLevel.getOutputCount()){
+        Bottle& batteryBottle = p->outputPortBatteryLevel.prepare();
+        batteryBottle.clear();
+        batteryBottle.addFloat64(batteries.getLevel(instance));
+        p->outputPortBatteryLevel.write();
     }
 
-    if(rechargeTime_remaining > 0){
-        batteryLevel = recharge();
-        rechargeTime_remaining--;
+    if(p->outputPortNoBattery.getOutputCount()){
+        Bottle& noBatteryBottle = p->outputPortNoBattery.prepare();
+        noBatteryBottle.clear();
+        noBatteryBottle.addInt16(noBattery(instance));
+        p->outputPortNoBattery.write();
     }
+}
 
-    bool noBat = noBattery();
+void batterySensorThread::tick() {
+    now = time(0);
+    char* timeNow_ = ctime(&now);
+    timeNow = timeNow_;
+    erase_all(timeNow, "\n");
 
-    if(noBat)
-        batteryLevel = MIN_BATTERY_LEVEL;//TODO: stop all the application in this case (not if is using RL -- in this case just reset the battery value)
+    unique_lock<mutex> lock(batteryMutex);
 
-    Bottle battery;
-    battery.clear();
-    battery.addFloat64(batteryLevel);
+    for(int i = 0; i < instances; i++)
+        readInstancePorts(i);
 
-    if(outputPortBatteryLevel.getOutputCount()){
-        outputPortBatteryLevel.prepare() = battery;
-        outputPortBatteryLevel.write();
+    if(instances == 1){
+        cout<<"decreaseRate: "<<batteries.getDecreaseRate(0)<<endl;
+        if(batteries.getRechargeTicks(0) > 0)
+            cout<<"Recharge " << batteries.getLevel(0) + VALUE_TO_RECHARGE << endl;
     }
 
-    Bottle noBatteryBottle;
-    noBatteryBottle.clear();
-    noBatteryBottle.addInt16(noBat);
+    //consumption, recharge and min level of all the batteries (TODO: stop all the application when there is no battery -- not if is using RL, in this case just reset the battery value)
+    batteries.step();
 
-    if(outputPortNoBattery.getOutputCount()){
-        outputPortNoBattery.prepare() = noBatteryBottle;
-        outputPortNoBattery.write();
-    }
-    cout<<"batteryLevel: "<<batteryLevel<<endl;
+    for(int i = 0; i < instances; i++)
+        writeInstancePorts(i);
+
+    if(instances == 1)
+        cout<<"batteryLevel: "<<batteries.getLevel(0)<<endl;
 
     saveData();
 }
@@ -290,15 +341,23 @@ bool batterySensorThread::processing(){
 }
 
 void batterySensorThread::threadRelease() {
-    inputPortRecharge.interrupt();
-    outputPortBatteryLevel.interrupt();
-    inputUpdBatteryConsPort.interrupt();
-    outputPortNoBattery.interrupt();
-    inputPortResetBattery.interrupt();
-
-    inputPortRecharge.close();
-    outputPortBatteryLevel.close();
-    inputUpdBatteryConsPort.close();
-    outputPortNoBattery.close();
-    inputPortResetBattery.close();
-}
\ No newline at end of file
+    closeAllPorts();
+}
+
+//also after a failed openAllPorts (the ports not opened are just closed again)
+void batterySensorThread::closeAllPorts() {
+    for(int i = 0; i < ports.size(); i++){
+        ports[i]->inputPortRecharge.interrupt();
+        ports[i]->outputPortBatteryLevel.interrupt();
+        ports[i]->inputUpdBatteryConsPort.interrupt();
+        ports[i]->outputPortNoBattery.interrupt();
+        ports[i]->inputPortResetBattery.interrupt();
+
+        ports[i]->inputPortRecharge.close();
+        ports[i]->outputPortBatteryLevel.close();
+        ports[i]->inputUpdBatteryConsPort.close();
+        ports[i]->outputPortNoBattery.close();
+        ports[i]->inputPortResetBattery.close();
+    }
+    ports.clear();
+}
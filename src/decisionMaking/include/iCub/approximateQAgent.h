@@ -7,6 +7,8 @@
 #include <iostream>
 #include <string.h>
 
+#include "iCub/csvParser.h"
+
 #define EGREEDY_DECAY_LINEAR         "linear"
 #define EGREEDY_DECAY_EXPONENTIAL    "exponential"
 #define EGREEDY_DECAY_CONSTANT       "constant"
@@ -62,7 +64,16 @@ class approximateQAgent{
         void shiftStateFeatures();
         
         double getQvalue(int actionIndex, int state_S_or_SL);
+        double getQvalue(int actionIndex, const double* state);
         double getMaxQValue();
+
+        /**
+        * state that setFeatures would compose after shiftStateFeatures, without changing the agent (used to speculate the next action)
+        * @param preview total_featuresState values
+        */
+        void previewFeatures(double newFeatures[], int actionDone, double* preview);
+        int getGreedyAction(const double* state);
+        int getNumberOfStateFeatures();
         
         void update(int actionIdid, double reward);
  
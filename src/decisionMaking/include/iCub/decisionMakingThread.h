@@ -38,7 +38,11 @@
 #include <boost/algorithm/string.hpp>
 #include <algorithm>
 #include <random>
+#include <set>
+#include <atomic>
 #include "iCub/approximateQAgent.h"
+#include "iCub/connectionBarrier.h"
+#include "iCub/monitoredThread.h"
 #include <string.h>
 
 //enum robotState {initial, idle, interact, recharge, powerOff, play, endInteraction};
@@ -53,6 +57,15 @@ enum robotState {idle, interact, recharge, play, lookDown, initial, endInteracti
 #define TIME_SPEECH         3
 #define TIME_RECHARGE       6
 
+//Completion events of the action module (id result command)
+#define ACTION_DONE_TIMEOUT     30      //s without all the completions of a behavior before considering it done
+#define DONE_POLL_PERIOD        0.05
+#define REFLEX_WINDOW           2       //s, the touch perceived is the one of the reflex (they come by different paths)
+
+//Next behavior computed while the current one is executed
+#define SPECULATION_MAX_AGE     1.0     //s, the data read while speculating is still used to dispatch the next behavior
+#define NO_SPECULATION          -1
+
 #define LEARNING_PHASE      "learn"
 #define TESTING_PHASE       "evaluate"
 #define FINETUNING_PHASE    "finetuning"
@@ -73,7 +86,26 @@ enum robotState {idle, interact, recharge, play, lookDown, initial, endInteracti
 
 #define UNDEF -999
 
-class decisionMakingThread : public yarp::os::PeriodicThread {
+//Layout of the drive-state message (/motivation/driveState:o). Must be the same values in motivation
+#define STATE_EXPLORE_DRIVE     0
+#define STATE_SURVIVE_DRIVE     1
+#define STATE_AFFECT_DRIVE      2
+#define STATE_BOREDOM           3
+#define STATE_COMFORT           4
+#define STATE_BATTERY           5
+#define STATE_OBJECT_COLOR      6
+#define STATE_EXTRA_DRIVES      7
+
+//Candidate of the next behavior (greedy Q over the last data) with what it needs already resolved
+typedef struct nextBehavior_{
+    int behavior;                       //NO_SPECULATION when there is no candidate
+    double timeOfData;                  //when the data used to compute it was read
+    double* state;                      //state features previewed in the agent
+    std::string gazeTarget;             //first gaze of the play with the fixed objects
+    yarp::os::Bottle objectData;        //object chosen by the motivation (empty if not in the FOV)
+}nextBehavior;
+
+class decisionMakingThread : public monitoredThread {
 private:
 
     std::string robot;              // name of the robot
@@ -99,7 +131,13 @@ private:
     std::time_t timeInitial;
 
     std::time_t timeOfAction;
-    float durationOfAction;
+    float durationOfAction;             //estimated, only used when the completion of the commands is not received
+
+    bool completionEvents;              //actionDone:i connected at startup, fixed for the whole run (no switch in the middle of a behavior)
+    std::set<int> pendingCommands;      //ids of the commands sent and not completed yet
+    int nextCommandId;
+    double timeLastCommand;
+    double minimumEndOfAction;          //behaviors that last more than their commands (recharge)
 
     time_t timeInitExperiment;
     int durationOfExperiment = 300;//600;   //time in seconds (so, 10 minutes)
@@ -134,6 +172,7 @@ private:
     //yarp::os::Bottle specificObject;                                                       
     yarp::os::Bottle* allObjsSeen;
     std::string colorObj;  
+    yarp::os::Stamp driveStateStamp;    //sequence number and time of the last drive state read
     int numberOfObjectsScene;
     int indexRobotAsObject;
 
@@ -193,10 +232,8 @@ private:
 
     double PERCEN_THRE;
 
-    //Input from Motivation Module
-    yarp::os::BufferedPort<yarp::os::Bottle> inputPortBoredomDriveObject;
-    yarp::os::BufferedPort<yarp::os::Bottle> inputSurvivalDrive;
-    yarp::os::BufferedPort<yarp::os::Bottle> inputAffectDrive;
+    //Input from Motivation Module: all the drives and needs of the same step (layout in STATE_*)
+    yarp::os::BufferedPort<yarp::os::Bottle> inputDriveStatePort;
 
     //Input from Perception Module
     yarp::os::BufferedPort<yarp::os::Bottle> inputAllObjectsPerceived;
@@ -210,6 +247,15 @@ private:
 
     //Output to Action Module
     yarp::os::BufferedPort<yarp::os::Bottle> outputActionPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> inputActionDonePort;           //completion of the commands sent
+    yarp::os::BufferedPort<yarp::os::Bottle> inputReflexPort;               //touch reflexes done by action (part target)
+    double lastReflex;
+    bool reflexDone;                    //the robot already looked at the part touched (reflex in the last REFLEX_WINDOW s)
+
+    std::atomic<double> timeFirstDecision{-1.0};  //-1 until the first behavior is sent, read by the launcher to measure the startup
+
+    nextBehavior speculation;
+    int speculationHits, speculationMisses;
     
     yarp::os::BufferedPort<yarp::os::Bottle> outputUpdateBoredomPort;
     yarp::os::BufferedPort<yarp::os::Bottle> outputUpdBatteryConsPort;
@@ -220,10 +266,6 @@ private:
     yarp::os::BufferedPort<yarp::os::Bottle> outputPortEndInitialBehavior;
 
     yarp::os::BufferedPort<yarp::os::Bottle> outputPortSaturetedAffect;
-
-    //Ports used to debug the behavior of the needs (Boredom, Comfort)
-    yarp::os::BufferedPort<yarp::os::Bottle> inputComfortPort;
-    yarp::os::BufferedPort<yarp::os::Bottle> inputBoredomPort;
     
 public:
     /**
@@ -257,7 +299,7 @@ public:
     /**
     *  active part of the thread
     */
-    void run();
+    void tick() override;
 
     /**
     * function that sets the rootname of all the ports that are going to be created by the thread
@@ -287,10 +329,9 @@ public:
     void initAllVars();
 
     void getData();
-    void readBoredomDriveData();
-    void readBatteryDriveData();
-    void readAffectDriveData();
+    void readDriveState();
     void readSkinPerceived();
+    void readReflex();
     void readAffectPerceived();
     void readObjectsPerceived();
 
@@ -298,6 +339,15 @@ public:
 
     void checkIfNoBattery();
 
+    double getTimeFirstDecision();
+
+    /**
+    * while a behavior is executed: read the data, choose the candidate next behavior and prefetch its targets
+    */
+    void speculateNextBehavior();
+    void getDataForDecision();
+    bool waitEndOfAction(double maxTime);
+
     std::string lookAtTouchedPart(int originOfTouch);
 
     yarp::os::Bottle getObjectCoords(std::string colorToLookAt);
@@ -317,6 +367,14 @@ public:
 
     void writeCommand(std::string commandSM);
 
+    void readActionDone();
+    bool actionInProgress();
+
+    /**
+    * wait until all the commands sent are done, at most maxTime s (the whole time if the completion is not received)
+    */
+    void waitCommandsDone(double maxTime);
+
     void updateBatteryConsumption(std::string behavior);
 
     void saveData(robotState behavior);
@@ -5,7 +5,6 @@
 #include <fstream>
 #include <random>
 #include <algorithm>
-#include <sstream>
 
 using namespace std;
 
@@ -69,24 +68,30 @@ void approximateQAgent::setEpsilon(double epsilon_){
 }
 
 bool approximateQAgent::recoverWeights(){
-    ifstream fin;
-    fin.open(weightsFilename); 
-    string myline;
-    
-    if(fin.is_open()){
-        int i = 0;
-        while(fin){    
-            getline(fin, myline);
-            istringstream iss(myline);
-            string token;
-            while(getline(iss, token, ',')){
-                cout<<token<< " ";
-                featuresPerBehavior[i] = stod(token);
-                i++;
-            }
+    csvParser parser;
+    int totalWeights = total_behaviors * total_featuresState;
+
+    if(!parser.open(weightsFilename)){
+        cout<<parser.getError()<<endl;
+        return false;
+    }
+
+    int i = 0;
+    while(parser.readLine()){
+        if(i + parser.size() > totalWeights){
+            cout<<weightsFilename<<":"<<parser.getLineNumber()<<": more weights than the "<<totalWeights<<" expected"<<endl;
+            return false;
         }
-    }else{
-        cout<<"Couldn't open the "<<weightsFilename<<" file"<<endl;
+        for(int j = 0; j < parser.size(); j++)
+            featuresPerBehavior[i++] = parser.asDouble(j);
+        if(!parser.ok()){
+            cout<<parser.getError()<<endl;
+            return false;
+        }
+    }
+
+    if(i != totalWeights){
+        cout<<weightsFilename<<": "<<i<<" weights, "<<totalWeights<<" expected"<<endl;
         return false;
     }
 
@@ -168,6 +173,19 @@ void approximateQAgent::shiftStateFeatures(){
         stateFeatures[i] = stateFeatures[i + features];
 }
 
+//Same as shiftStateFeatures + setFeatures, but in preview
+void approximateQAgent::previewFeatures(double newFeatures[], int actionDone, double* preview){
+    int i;
+    for(i = 0; i < features * previousStatesToRepeat; i++)
+        preview[i] = stateFeatures[i + features];
+
+    for(int j = 0; i < total_featuresState - useLastBehavior; i++, j++)
+        preview[i] = newFeatures[j];
+
+    if(useLastBehavior)
+        preview[i] = actionDone;
+}
+
 //https://stackoverflow.com/questions/3473438/return-array-in-a-function
 double* approximateQAgent::getFeatures(int state_S_or_SL){
      if(state_S_or_SL == 0)
@@ -177,15 +195,36 @@ double* approximateQAgent::getFeatures(int state_S_or_SL){
 }
 
 double approximateQAgent::getQvalue(int actionIndex, int state_S_or_SL){
+    return getQvalue(actionIndex, getFeatures(state_S_or_SL));
+}
+
+double approximateQAgent::getQvalue(int actionIndex, const double* state){
     double qValue = 0;
-    double *features = getFeatures(state_S_or_SL);
 
     for(int i = 0; i < total_featuresState; i++)
-        qValue += features[i] * featuresPerBehavior[actionIndex * total_featuresState + i];
+        qValue += state[i] * featuresPerBehavior[actionIndex * total_featuresState + i];
 
     return qValue;
 }
 
+int approximateQAgent::getGreedyAction(const double* state){
+    int selectedAction = 0; //Assume that the first is the better
+    double maxQ = getQvalue(0, state);
+    double value;
+    for(int i = 1; i < total_behaviors; i++){
+        value = getQvalue(i, state);
+        if(value > maxQ){
+            maxQ = value;
+            selectedAction = i;
+        }
+    }
+    return selectedAction;
+}
+
+int approximateQAgent::getNumberOfStateFeatures(){
+    return total_featuresState;
+}
+
 double approximateQAgent::getMaxQValue(){
     double maxQinSL, value;
 
@@ -233,7 +272,6 @@ void approximateQAgent::updateEpsilon(int episodesDone, int totalEpisodes){
 
 int approximateQAgent::getAction(){
     int action, selectedAction;
-    double maxQinSL;
 
     if(getRandomDouble(0, 1) < epsilon){
         //exploration, random choice
@@ -241,16 +279,7 @@ int approximateQAgent::getAction(){
         selectedAction = action;
     }else{
         //exploitation, max value for given state
-        selectedAction = 0; //Assume that the first is the better
-        maxQinSL = getQvalue(0, 1);
-        double value;
-        for(int i = 1; i < total_behaviors; i++){
-            value = getQvalue(i, 1);
-            if(value > maxQinSL){
-                maxQinSL = value;
-                selectedAction = i;
-            }
-        }
+        selectedAction = getGreedyAction(getFeatures(1));
     }
     return selectedAction;
 }
\ No newline at end of file
@@ -129,6 +129,9 @@ bool decisionMakingModule::respond(const Bottle& command, Bottle& reply)
     string helpMessage =  string(getName().c_str()) + 
                 " commands are: \n" +  
                 "help \n" +
+                "ready : ok when the module is running (connections done), wait before \n" +
+                "period : period ticks overruns meanUsed maxUsed jitter (s) of the thread \n" +
+                "firstDecision : time (s) when the first behavior was sent (-1 before) \n" +
                 "quit \n";
     reply.clear(); 
 
@@ -142,6 +145,15 @@ bool decisionMakingModule::respond(const Bottle& command, Bottle& reply)
         cout << helpMessage;
         reply.addString("ok");
     }
+    else if (command.get(0).asString()=="ready") {
+        reply.addString(pThread != nullptr && pThread->isRunning() ? "ok" : "wait");
+    }
+    else if (command.get(0).asString()=="period" && pThread != nullptr) {
+        pThread->addPeriodStats(reply);
+    }
+    else if (command.get(0).asString()=="firstDecision") {
+        reply.addFloat64(pThread != nullptr ? pThread->getTimeFirstDecision() : -1.0);
+    }
     
     return true;
 }
@@ -33,16 +33,16 @@ using namespace boost;
 #define THPERIOD 0.5//s
 #define NON_EXIST -1 //Must be the same value defined in objectPerception module
 
-decisionMakingThread::decisionMakingThread():PeriodicThread(THPERIOD) {
+decisionMakingThread::decisionMakingThread():monitoredThread(THPERIOD) {
     robot = "icub";        
 }
 
-decisionMakingThread::decisionMakingThread(string _robot, string _configFile):PeriodicThread(THPERIOD){
+decisionMakingThread::decisionMakingThread(string _robot, string _configFile):monitoredThread(THPERIOD){
     robot = _robot;
     configFile = _configFile;
 }
 
-decisionMakingThread::decisionMakingThread(string _robot, ResourceFinder &_rf, string _robot_color, string _robot_profile):PeriodicThread(THPERIOD){
+decisionMakingThread::decisionMakingThread(string _robot, ResourceFinder &_rf, string _robot_color, string _robot_profile):monitoredThread(THPERIOD){
     robot = _robot;
     rf = _rf;
     robot_color = _robot_color;
@@ -52,6 +52,7 @@ decisionMakingThread::decisionMakingThread(string _robot, ResourceFinder &_rf, s
 decisionMakingThread::~decisionMakingThread() {
     delete QL_agent;
     delete [] featuresToMDP;
+    delete [] speculation.state;
     delete [] allRewardsTraining;
 }
 
@@ -86,18 +87,8 @@ bool decisionMakingThread::openAllPorts(){
         return false;  // unable to open; let RFModule know so that it won't run
     }
 
-    if(!inputPortBoredomDriveObject.open(getName("/exploreDriveObject:i").c_str())){
-        yError("unable to open port to send unmasked events ");
-        return false;
-    }
-
-    if(!inputSurvivalDrive.open(getName("/survivalDrive:i").c_str())){
-        yError("unable to open port to receive output");
-        return false;  // unable to open; let RFModule know so that it won't run
-    }
-
-    if(!inputAffectDrive.open(getName("/affectDrive:i").c_str())){
-        yError("unable to open port to receive output");
+    if(!inputDriveStatePort.open(getName("/driveState:i").c_str())){
+        yError("unable to open port to receive input");
         return false;  // unable to open; let RFModule know so that it won't run
     }
 
@@ -116,6 +107,17 @@ bool decisionMakingThread::openAllPorts(){
         return false;
     }
 
+    if(!inputActionDonePort.open(getName("/actionDone:i").c_str())){
+        yError("unable to open port to receive the completion of the commands");
+        return false;
+    }
+    inputActionDonePort.setStrict();
+
+    if(!inputReflexPort.open(getName("/reflex:i").c_str())){
+        yError("unable to open port to receive the touch reflexes");
+        return false;
+    }
+
     /* if(!ouputStopApplication.open(getName("/stopApplication:o").c_str())){
         yError("unable to open port to receive output");
         return false;
@@ -160,41 +162,34 @@ bool decisionMakingThread::openAllPorts(){
         }
     }
 
-    //######### Just for debugging #########
-    if(!inputBoredomPort.open(getName("/boredom:i").c_str())){
-        yError("unable to open port to receive output");
-        return false;  // unable to open; let RFModule know so that it won't run
-    }
-
-    if(!inputComfortPort.open(getName("/comfort:i").c_str())){
-        yError("unable to open port to receive output");
-        return false;  // unable to open; let RFModule know so that it won't run
-    }
-
     return true;
 }
 
 bool decisionMakingThread::waitForPortConnections(){
-    while(inputInteractionPort.getInputCount() < 1);
-    while(inputNoBatteryPort.getInputCount() < 1);
-    while(inputPortBoredomDriveObject.getInputCount() < 1);
-    while(inputSurvivalDrive.getInputCount() < 1);
-    while(inputAffectDrive.getInputCount() < 1);
-    while(inputAllObjectsPerceived.getInputCount() < 1);
-    while(inputSkinPerceivedPort.getInputCount() < 1);
-    //while(inputAffectPerceivedPort.getInputCount() < 1);
-    while(outputActionPort.getOutputCount() < 1);
-    while(outputUpdateBoredomPort.getOutputCount() < 1);
-    while(outputUpdBatteryConsPort.getOutputCount() < 1);
+    connectionBarrier connections;
+    connections.configure(rf.findGroup("variables"));
+    connections.addInput(inputInteractionPort);
+    connections.addInput(inputNoBatteryPort);
+    connections.addInput(inputDriveStatePort);
+    connections.addInput(inputAllObjectsPerceived);
+    connections.addInput(inputSkinPerceivedPort);
+    //connections.addInput(inputAffectPerceivedPort);
+    connections.addOutput(outputActionPort);
+    connections.addOutput(outputUpdateBoredomPort);
+    connections.addOutput(outputUpdBatteryConsPort);
 
     if(mode == LEARNING_PHASE || mode == TESTING_PHASE || mode == FINETUNING_PHASE){
-        while(outputPortResetBattery.getOutputCount() < 1);
-        while(outputPortResetBoredom.getOutputCount() < 1);
+        connections.addOutput(outputPortResetBattery);
+        connections.addOutput(outputPortResetBoredom);
     }
 
+    //completion events and reflexes of the action, without them the durations are estimated
+    connections.addInput(inputActionDonePort, true);
+    connections.addInput(inputReflexPort, true);
+
    // while(ouputStopApplication.getOutputCount() < 5);//one for each module that I want to stop (and it is defined in XML)
 
-    return true;
+    return connections.wait();
 }
 
 bool decisionMakingThread::setQL(){
@@ -207,6 +202,7 @@ bool decisionMakingThread::setQL(){
     QL_agent->setTotalBehaviors(endInteraction + 1 - numberOfStatesToDesconsider); //Simplified equation explained above
 
     QL_agent->setNumberOfFeatures(features, previousStatesToRepeat, useLastBehavior);
+    speculation.state = new double[QL_agent->getNumberOfStateFeatures()];
     
     if(mode.compare(LEARNING_PHASE) == 0){ //Training phase
         QL_agent->init_featuresWeight();
@@ -356,6 +352,7 @@ void decisionMakingThread::initAllVars(){
     allObjsSeen = nullptr;
     numberOfObjectsScene = 0;
     indexRobotAsObject = -2;
+    completionEvents = false;
 
     indexSeq_objToPlay = 0;
     indexSoundPlay = 0;
@@ -370,6 +367,16 @@ void decisionMakingThread::initAllVars(){
 
     timeOfAction = Time::now();
     durationOfAction = 0;
+    nextCommandId = 0;
+    reflexDone = false;
+    lastReflex = -REFLEX_WINDOW;
+    timeLastCommand = Time::now();
+    minimumEndOfAction = 0;
+
+    speculation.behavior = NO_SPECULATION;
+    speculation.timeOfData = -SPECULATION_MAX_AGE;
+    speculationHits = 0;
+    speculationMisses = 0;
 
     current_episode = 0;
     steps = 0;
@@ -395,6 +402,8 @@ void decisionMakingThread::initAllVars(){
 }
 
 bool decisionMakingThread::threadInit(){
+    configurePeriod(rf.findGroup("periods"), "decisionMaking");
+
     filepath = rf.find("filepath").asString();
     filenameAllData = filepath + filenameAllData;
     filenameRewards = filepath + filenameRewards;
@@ -420,6 +429,8 @@ bool decisionMakingThread::threadInit(){
         yError("Connection Error");
         return false;
     }
+    completionEvents = inputActionDonePort.getInputCount() > 0;
+    yInfo("End of the behaviors: %s", completionEvents ? "completion events of the action" : "estimated durations");
 
     timeInitial = Time::now();
     timeInitExperiment = Time::now();//Here is "fake" because we start to really count the time after the initial state (except for the RL agent)
@@ -427,28 +438,27 @@ bool decisionMakingThread::threadInit(){
     return true;
 }
 
-void decisionMakingThread::readBatteryDriveData(){
-    if(inputSurvivalDrive.getInputCount()){
-        Bottle* inpuSurviveDriveB = inputSurvivalDrive.read(true);
-        surviveDrive = inpuSurviveDriveB->get(0).asFloat64();
-        cout<<"surviveDrive: "<<surviveDrive<<endl;
-    }
-}
+//All the drives come from the same step of the motivation module (one message), so they are always consistent
+void decisionMakingThread::readDriveState(){
+    if(inputDriveStatePort.getInputCount()){
+        Bottle* state = inputDriveStatePort.read(true);
+        if(state == nullptr || state->size() < STATE_EXTRA_DRIVES){
+            yWarning("invalid drive state received from motivation");
+            return;
+        }
+        inputDriveStatePort.getEnvelope(driveStateStamp);
 
-void decisionMakingThread::readAffectDriveData(){
-   if(inputAffectDrive.getInputCount()){
-        Bottle* inputAffectDriveB = inputAffectDrive.read(true);
-        affectDrive = inputAffectDriveB->get(0).asFloat64();
-        cout<<"affectDrive: "<<affectDrive<<endl;
-    }
-}
+        surviveDrive = state->get(STATE_SURVIVE_DRIVE).asFloat64();
+        affectDrive = state->get(STATE_AFFECT_DRIVE).asFloat64();
+        boredomDrive = state->get(STATE_EXPLORE_DRIVE).asFloat64();
+        colorObj = state->get(STATE_OBJECT_COLOR).asString();
 
-void decisionMakingThread::readBoredomDriveData(){
-    if(inputPortBoredomDriveObject.getInputCount()){
-        Bottle* boredomDriveObjData = inputPortBoredomDriveObject.read(true);
-        boredomDrive = boredomDriveObjData->get(0).asFloat64();
-        colorObj = boredomDriveObjData->get(1).asString();//toSTring();
+        cout<<"Drive state #"<<driveStateStamp.getCount()<<endl;
+        cout<<"surviveDrive: "<<surviveDrive<<endl;
+        cout<<"affectDrive: "<<affectDrive<<endl;
         cout<<"Boredom Drive: "<<boredomDrive<<" next objChoosen: "<<colorObj<<endl;
+        cout<<"Boredom: "<<state->get(STATE_BOREDOM).asFloat64()<<endl;
+        cout<<"Comfort: "<<state->get(STATE_COMFORT).asFloat64()<<endl;
     }
 }
 
@@ -478,6 +488,17 @@ void decisionMakingThread::readSkinPerceived(){
     }
 }
 
+void decisionMakingThread::readReflex(){
+    while(inputReflexPort.getPendingReads() > 0){
+        Bottle* reflex = inputReflexPort.read(false);
+        if(reflex == nullptr)
+            break;
+        cout<<"Touch reflex done: "<<reflex->get(1).asString()<<endl;
+        lastReflex = Time::now();
+    }
+    reflexDone = Time::now() - lastReflex < REFLEX_WINDOW;
+}
+
 void decisionMakingThread::readAffectPerceived(){
     if(inputInteractionPort.getInputCount()){
         Bottle* input = inputInteractionPort.read(false);
@@ -611,30 +632,75 @@ void decisionMakingThread::getNextAction(){
     //Choose an action to execute
     actionRL = QL_agent->getAction();
     cout<<"actionRL: "<<actionRL<<endl;
+
+    //the update or the exploration can choose another one, then its targets are resolved when it is executed
+    if(speculation.behavior != NO_SPECULATION){
+        if(actionRL == speculation.behavior)
+            speculationHits++;
+        else{
+            speculationMisses++;
+            speculation.behavior = NO_SPECULATION;
+        }
+        cout<<"Speculated behavior hits: "<<speculationHits<<" misses: "<<speculationMisses<<endl;
+    }
+
     detailBehaviorActions(robotState(actionRL));//access enum by index c++ (https://stackoverflow.com/questions/321801/enum-c-get-by-index)
+    speculation.behavior = NO_SPECULATION;
+}
+
+void decisionMakingThread::speculateNextBehavior(){
+    colorObj = "";
+    getData();
+    speculation.timeOfData = Time::now();
+
+    //greedy choice over the state the next decision will have, the agent is not changed
+    composeFeatures();
+    QL_agent->previewFeatures(featuresToMDP, previousBehavior, speculation.state);
+    speculation.behavior = QL_agent->getGreedyAction(speculation.state);
+
+    speculation.gazeTarget = "";
+    speculation.objectData.clear();
+    if(speculation.behavior == play){
+        speculation.gazeTarget = lookAtSpecificObject(objectsSequence[indexSeq_objToPlay]);
+        if(colorObj.compare("") != 0 && allObjsSeen != nullptr && numberOfObjectsScene > 0)
+            speculation.objectData = getObjectCoords(colorObj);
+    }
+    cout<<"Executing action: "<<actionRL<<"   next candidate: "<<speculation.behavior<<endl;
+}
+
+//the data read while executing the last behavior is used if it is recent, so the next one starts without waiting for new messages
+void decisionMakingThread::getDataForDecision(){
+    bool fresh = Time::now() - speculation.timeOfData < SPECULATION_MAX_AGE;
+    speculation.timeOfData = -SPECULATION_MAX_AGE;//used once
+    if(fresh)
+        return;
+
+    //the targets prefetched are older than the data
+    speculation.behavior = NO_SPECULATION;
+    colorObj = "";
+    getData();
+}
+
+bool decisionMakingThread::waitEndOfAction(double maxTime){
+    double start = Time::now();
+    while(actionInProgress() && Time::now() - start < maxTime)
+        Time::delay(DONE_POLL_PERIOD);
+    return !actionInProgress();
 }
 
 void decisionMakingThread::getData(){
     //Data from the Motivation modules
-    readBatteryDriveData();
-    readAffectDriveData();
-    readBoredomDriveData();
+    readDriveState();
 
     //Data from the Perception modules
     readAffectPerceived();
     readSkinPerceived();
+    readReflex();
     readObjectsPerceived();
+}
 
-    //DATA FOR DEBUGGING
-    if(inputBoredomPort.getInputCount()){
-        Bottle* boredomB = inputBoredomPort.read(true);
-        cout<<"Boredom: "<<boredomB->get(0).asFloat64()<<endl;
-    }
-
-    if(inputComfortPort.getInputCount()){
-        Bottle* comfortB = inputComfortPort.read(true);
-        cout<<"Comfort: "<<comfortB->get(0).asFloat64()<<endl;
-    }
+double decisionMakingThread::getTimeFirstDecision(){
+    return timeFirstDecision;
 }
 
 void decisionMakingThread::checkIfNoBattery(){
@@ -643,7 +709,7 @@ void decisionMakingThread::checkIfNoBattery(){
     cout<<"No Battery: "<<noBattery<<endl;
 }
 
-void decisionMakingThread::run(){
+void decisionMakingThread::tick(){
     now = time(0);
     char* timeNow_ = ctime(&now);
     timeNow = timeNow_;
@@ -657,10 +723,16 @@ void decisionMakingThread::run(){
         makeDecision_RuleBased();//Use this one for the pre-defined behavior with fixed values (used to collect data in a HRI experiment to then go to RL -- first phase)
     else
         makeDecision_DriveBased();
+
+    //nothing to decide while recharging
+    if(previousBehavior == recharge)
+        requestSlowPeriod();
+    else
+        requestNominalPeriod();
 }
 
 void decisionMakingThread::makeDecision_RuleBased(){
-    if(Time::now() - timeOfAction >= durationOfAction){
+    if(!actionInProgress()){
         //Tells the motivation that can start compute the affect and explore drives
         if(previousBehavior == initial && first == false){
             if(outputPortEndInitialBehavior.getOutputCount()){
@@ -702,11 +774,13 @@ void decisionMakingThread::makeDecision_RuleBased(){
                 cout<<"originOfTouch: "<<originOfTouch<<endl;
                 
                 if(originOfTouch != noTouch){
-                    string gazeDirection = lookAtTouchedPart(originOfTouch);
-                    writeCommand("gaze,moveHeadDirection," + gazeDirection);
-                    Time::delay(3);
-                    writeCommand("gaze,moveHeadDirection,home");
-                    durationOfAction += 2 * TIME_GAZE;
+                    if(!reflexDone){//the touch reflex of action already looked at the part
+                        string gazeDirection = lookAtTouchedPart(originOfTouch);
+                        writeCommand("gaze,moveHeadDirection," + gazeDirection);
+                        Time::delay(3);
+                        writeCommand("gaze,moveHeadDirection,home");
+                        durationOfAction += 2 * TIME_GAZE;
+                    }
                     waitingInteraction = 0;
                 }
 
@@ -750,7 +824,7 @@ void decisionMakingThread::makeDecision_RuleBased(){
 }
 
 void decisionMakingThread::makeDecision_DriveBased(){
-    if(Time::now() - timeOfAction >= durationOfAction){
+    if(!actionInProgress()){
         //Tells the motivation that can start compute the affect and explore drives
         if(previousBehavior == initial && first == false){
             timeInitExperiment = Time::now();
@@ -826,7 +900,7 @@ void decisionMakingThread::makeDecision_DriveBased(){
                 if(originOfTouch != noTouch){
                     waitingInteraction = 0;
                     indexInteractionReply++;
-                    if(indexInteractionReply % 3 == 0){
+                    if(indexInteractionReply % 3 == 0 && !reflexDone){//the touch reflex of action already looked at the part
                         string gazeDirection = lookAtTouchedPart(originOfTouch);
                         writeCommand("gaze,moveHeadDirection," + gazeDirection);
                         Time::delay(3);
@@ -844,7 +918,7 @@ void decisionMakingThread::makeDecision_DriveBased(){
             if(previousBehavior == recharge && behavior != recharge){ //openEyes when finish the recharge behavior and change to the next one
                 writeCommand("speech,#YAWN01#");
                 writeCommand("eyelids,1.0,0.0,open");
-                Time::delay(3);
+                waitCommandsDone(3);
             }
             
             if(behavior != idle)
@@ -874,7 +948,7 @@ void decisionMakingThread::makeDecision_DriveBased(){
             }
         } 
     }else{
-        if(behavior == recharge)
+        if(behavior == recharge && pendingCommands.empty())//one sound at a time, the next one after the previous is done
             writeCommand("speech,#SLEEP02#");
         cout<<"Action in progress"<<endl;
     }
@@ -883,8 +957,6 @@ void decisionMakingThread::makeDecision_DriveBased(){
 }
 
 void decisionMakingThread::makeDecision_RL(){
-    colorObj = "";
-
     if(previousBehavior == recharge)
         writeCommand("eyelids,1.0,0.0,open");
 
@@ -894,11 +966,17 @@ void decisionMakingThread::makeDecision_RL(){
 
     cout<<"Time: "<<Time::now() - timeOfAction<<endl;
 
-    if(Time::now() - timeOfAction >= durationOfAction){
+    //the next behavior is ready while this one is executed and it is sent as soon as this one is done (in this same cycle)
+    if(actionInProgress() && waitBufferPerception > previousStatesToRepeat){
+        speculateNextBehavior();
+        waitEndOfAction(getTimeLeftInCycle());
+    }
+
+    if(!actionInProgress()){
         if(noBattery){
             reset();
             allRewardsTraining[current_episode-1] += deathPunishment;//current_episode-1 cause in reset() there is current_episode++
-            getData();
+            getDataForDecision();
             featuresToRL();
             //Update the "table"
             QL_agent->update(previousBehavior, deathPunishment);
@@ -908,7 +986,7 @@ void decisionMakingThread::makeDecision_RL(){
         }else{
             durationOfAction = 0;
             //Get all the data needed to compose the features to be used in the MDP
-            getData();
+            getDataForDecision();
             if(!endExperiment()){
                 if(!endEpisode()){
                     featuresToRL();
@@ -935,7 +1013,7 @@ void decisionMakingThread::makeDecision_RL(){
                 }
             }
         }
-    }else
+    }else if(speculation.behavior == NO_SPECULATION)
         cout<<"Executing action: "<<actionRL<<endl;
     
     cout<<"Reward: "<<allRewardsTraining[current_episode]<<endl;
@@ -1022,7 +1100,7 @@ void decisionMakingThread::reset(){
 
     cout<<"Reseting"<<endl;
 
-    Time::delay(TIME_GAZE);//check the need of this command
+    waitCommandsDone(TIME_GAZE);//check the need of this command
 
     cout<<"----------------------"<<endl;
 }
@@ -1054,8 +1132,11 @@ void decisionMakingThread::playFixedObjects_CTP(){
     if(indexSeq_objToPlay >= 20)
         indexSeq_objToPlay = 0;
 
-    writeCommand("gaze,moveHeadDirection," + lookAtSpecificObject(i));
-    Time::delay(2);
+    if(speculation.behavior == play && !speculation.gazeTarget.empty())
+        writeCommand("gaze,moveHeadDirection," + speculation.gazeTarget);
+    else
+        writeCommand("gaze,moveHeadDirection," + lookAtSpecificObject(i));
+    waitCommandsDone(2);
     writeCommand("action,1.0,0.0,point_object_" + to_string(i));
     writeCommand("speech," + soundsPlay[indexSoundPlay]);
     
@@ -1063,10 +1144,10 @@ void decisionMakingThread::playFixedObjects_CTP(){
     if(indexSoundPlay == 24)
         indexSoundPlay = 0;
 
-    Time::delay(15);
+    waitCommandsDone(15);
     writeCommand("action,2.0,0.0,SaraHome");
 
-    Time::delay(4);
+    waitCommandsDone(4);
     writeCommand("gaze,moveHeadDirection,homeDown");
     durationOfAction += TIME_GAZE;
 
@@ -1077,7 +1158,7 @@ void decisionMakingThread::playDynamicObjects_ARE(){
     if(previousBehavior != play){
         writeCommand("homeARE");
         //updateBatteryConsumption("play");
-        Time::delay(3);
+        waitCommandsDone(3);
         //writeCommand("speech,Play!");
         //writeCommand("face,raise,smile");
         //Time::delay(1);
@@ -1091,7 +1172,10 @@ void decisionMakingThread::playDynamicObjects_ARE(){
         if(colorObj.compare("") != 0){//Play with the object indicated by the motivation module
             Bottle specificObjectData;
             specificObjectData.clear();
-            specificObjectData = getObjectCoords(colorObj);
+            if(speculation.behavior == play)
+                specificObjectData = speculation.objectData;
+            else
+                specificObjectData = getObjectCoords(colorObj);
             if(specificObjectData.size() != 0){
                 cout<<"Playing with the object indicated by the motivation"<<endl;
                 cout<<"specificObjData "<<specificObjectData.get(0).toString()<<endl;
@@ -1144,7 +1228,7 @@ void decisionMakingThread::definePlay(Bottle specificObjectData){
 
     durationOfAction += TIME_POINT_ARE + TIME_SPEECH;
 
-    Time::delay(3);
+    waitCommandsDone(3);
 
     updateBoredom();
 }
@@ -1208,6 +1292,13 @@ void decisionMakingThread::detailBehaviorActions(robotState behavior){
             ouputStopApplication.write();
         }
     }else{
+        if(timeFirstDecision < 0)
+            timeFirstDecision = Time::now();
+        //a new behavior preempts the gestures, speech and gaze of the previous one still running
+        if(behavior != previousBehavior && actionInProgress()){
+            cout<<"Stopping the previous behavior"<<endl;
+            writeCommand("stop");
+        }
         saveData(behavior);
         switch(behavior){
             case initial:
@@ -1222,9 +1313,9 @@ void decisionMakingThread::detailBehaviorActions(robotState behavior){
                 writeCommand("action,0.7,0.0,greet2");
                 writeCommand("action,0.7,0.0,greet1");
                 writeCommand("action,0.7,0.0,greet2");
-                Time::delay(5);
+                waitCommandsDone(5);
                 writeCommand("action,2.0,0.0,SaraHome");
-                Time::delay(1);
+                waitCommandsDone(1);
                 durationOfAction += TIME_SPEECH + TIME_CTP;
                 timeOfAction = Time::now();
                 break;
@@ -1235,7 +1326,7 @@ void decisionMakingThread::detailBehaviorActions(robotState behavior){
                     writeCommand("action,2.0,0.0,SaraHome");
                     writeCommand("gaze,moveHeadDirection,home");
                     writeCommand("face,neutral,neutral");
-                    Time::delay(2);
+                    waitCommandsDone(2);
                     durationOfAction += TIME_CTP + TIME_LEDS + TIME_GAZE;
                 }
                 writeCommand("gaze,lookAround");
@@ -1252,12 +1343,12 @@ void decisionMakingThread::detailBehaviorActions(robotState behavior){
                 if(previousBehavior != interact){
                     updateBatteryConsumption("interact");
                     writeCommand("action,2.0,0.0,SaraHome");
-                    Time::delay(2);
+                    waitCommandsDone(2);
                     writeCommand("speech," + soundsInteract[1]);
                     writeCommand("gaze,moveHeadDirection,home");
                     writeCommand("speech,care");
                     writeCommand("action,2.0,0.0,Interact");
-                    Time::delay(2);
+                    waitCommandsDone(2);
                     durationOfAction += TIME_LEDS + TIME_SPEECH + 2 * TIME_CTP + TIME_GAZE;
                 }else{
                     writeCommand("speech," + soundsInteract[indexSoundInteract]);
@@ -1268,9 +1359,9 @@ void decisionMakingThread::detailBehaviorActions(robotState behavior){
 
                     if(saturedAffect >= 15){//Mechanism to try to solve the affect drive when the person is not interacting and the drive is oversatured -- look to a photo in the environment
                         writeCommand("action,2.0,0.0,SaraHome");
-                        Time::delay(2);
+                        waitCommandsDone(2);
                         writeCommand("gaze,moveHeadDirection,rightUp");
-                        Time::delay(2);
+                        waitCommandsDone(2);
                         if(outputPortSaturetedAffect.getOutputCount()){
                             Bottle update;
                             update.clear();
@@ -1302,14 +1393,15 @@ void decisionMakingThread::detailBehaviorActions(robotState behavior){
                     writeCommand("speech,#BREATH02# Sleeeep!");
                     writeCommand("gaze,moveHeadDirection,home");
                     writeCommand("eyelids,1.0,0.0,close");
-                    Time::delay(3);
+                    waitCommandsDone(3);
                     writeCommand("face,neutral,neutral");
                     
                     durationOfAction += TIME_LEDS + TIME_SPEECH;
                 }
                 writeCommand("recharge");
                 durationOfAction += TIME_RECHARGE;
-                Time::delay(1.5);
+                minimumEndOfAction = Time::now() + TIME_RECHARGE;//sleeping lasts even if the commands are done
+                waitCommandsDone(1.5);
                 timeOfAction = Time::now();
                 break;
             //case jointInteraction/attention:
@@ -1355,7 +1447,7 @@ void decisionMakingThread::detailBehaviorActions(robotState behavior){
                 writeCommand("action,0.7,0.0,greet2");
                 writeCommand("action,0.7,0.0,greet1");
                 writeCommand("action,0.7,0.0,greet2");
-                Time::delay(5);
+                waitCommandsDone(5);
                 writeCommand("action,1.0,0.0,SaraHome");
                 durationOfAction = 3 * TIME_CTP + TIME_GAZE + TIME_SPEECH + TIME_LEDS;
                 timeOfAction = Time::now();
@@ -1373,12 +1465,56 @@ void decisionMakingThread::writeCommand(std::string commandSM){
     if(outputActionPort.getOutputCount()){
         bottleToSendAction.clear();
         bottleToSendAction.addString(commandSM);
+        //with the completion events connected the command has an id, the behavior ends when all the ids come back
+        if(completionEvents){
+            bottleToSendAction.addInt32(nextCommandId);
+            pendingCommands.insert(nextCommandId);
+            nextCommandId++;
+            timeLastCommand = Time::now();
+        }
         outputActionPort.prepare() = bottleToSendAction;
         outputActionPort.writeStrict();
         //outputActionPort.write();
     }
 }
 
+void decisionMakingThread::readActionDone(){
+    while(inputActionDonePort.getPendingReads() > 0){
+        Bottle* event = inputActionDonePort.read(false);
+        if(event == nullptr)
+            break;
+        pendingCommands.erase(event->get(0).asInt32());
+        cout<<"Action "<<event->get(1).asString()<<": "<<event->get(2).asString()<<endl;
+    }
+}
+
+bool decisionMakingThread::actionInProgress(){
+    if(!completionEvents)
+        return Time::now() - timeOfAction < durationOfAction;
+
+    readActionDone();
+    if(!pendingCommands.empty() && Time::now() - timeLastCommand >= ACTION_DONE_TIMEOUT){
+        yWarning("%d commands without completion after %d s, the behavior is considered done", (int)pendingCommands.size(), ACTION_DONE_TIMEOUT);
+        pendingCommands.clear();
+    }
+    return !pendingCommands.empty() || Time::now() < minimumEndOfAction;
+}
+
+void decisionMakingThread::waitCommandsDone(double maxTime){
+    if(!completionEvents){
+        Time::delay(maxTime);
+        return;
+    }
+
+    double start = Time::now();
+    while(Time::now() - start < maxTime){
+        readActionDone();
+        if(pendingCommands.empty())
+            return;
+        Time::delay(DONE_POLL_PERIOD);
+    }
+}
+
 void decisionMakingThread::updateBatteryConsumption(string behavior){
     Bottle updateBatteryCons;
     if(outputUpdBatteryConsPort.getOutputCount()){
@@ -1453,13 +1589,13 @@ bool decisionMakingThread::processing(){
 void decisionMakingThread::threadRelease() {
     inputInteractionPort.interrupt();
     inputNoBatteryPort.interrupt();
-    inputPortBoredomDriveObject.interrupt();
+    inputDriveStatePort.interrupt();
     inputAllObjectsPerceived.interrupt();
-    inputSurvivalDrive.interrupt();
-    inputAffectDrive.interrupt();
     inputSkinPerceivedPort.interrupt();
     //inputAffectPerceivedPort.interrupt();
     outputActionPort.interrupt();
+    inputActionDonePort.interrupt();
+    inputReflexPort.interrupt();
     ouputStopApplication.interrupt();
     outputUpdateBoredomPort.interrupt();
     outputUpdBatteryConsPort.interrupt();
@@ -1469,21 +1605,15 @@ void decisionMakingThread::threadRelease() {
     outputPortEndInitialBehavior.interrupt();
     outputPortSaturetedAffect.interrupt();
 
-
-    inputBoredomPort.interrupt();
-    inputComfortPort.interrupt();
-    inputBoredomPort.close();
-    inputComfortPort.close();
-
     inputInteractionPort.close();
     inputNoBatteryPort.close();
-    inputPortBoredomDriveObject.close();
+    inputDriveStatePort.close();
     inputAllObjectsPerceived.close();
-    inputSurvivalDrive.close();
-    inputAffectDrive.close();
     inputSkinPerceivedPort.close();
     //inputAffectPerceivedPort.close();
     outputActionPort.close();
+    inputActionDonePort.close();
+    inputReflexPort.close();
     ouputStopApplication.close();
     outputUpdateBoredomPort.close();
     outputUpdBatteryConsPort.close();
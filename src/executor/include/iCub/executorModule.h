@@ -0,0 +1,96 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file executorModule.h
+ * @brief Definition of the module that runs the threads of the modules in one process, for the boards with few cores.
+ *
+ * The ports keep the names of the modules (/perception, /motivation...), so the connections of the application
+ * (yarpmanager or the launcher) do not change.
+ */
+
+#ifndef _EXECUTOR_MODULE_H_
+#define _EXECUTOR_MODULE_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <yarp/os/all.h>
+#include <yarp/os/RFModule.h>
+#include <yarp/os/Network.h>
+#include <yarp/os/Log.h>
+
+//within project includes
+#include <iCub/cooperativeExecutor.h>
+
+class executorModule:public yarp::os::RFModule {
+
+    std::string moduleName;                  // name of the module
+    std::string robotName;                   // name of the robot
+    std::string handlerPortName;             // name of handler port
+
+    yarp::os::Port handlerPort;              // a port to handle messages
+    /*  */
+    cooperativeExecutor *pExecutor = nullptr; // runs the threads of the modules, created and started in configure() and stopped in close()
+    std::vector<monitoredThread*> threads;   // threads of the modules, in the order of the cycle
+
+    /**
+    *  create the thread of a module (nullptr if the module is unknown)
+    */
+    monitoredThread* createThread(const std::string& module, yarp::os::ResourceFinder &rf);
+
+public:
+    /**
+    *  configure all the parameters and return true if successful
+    * @param rf reference to the resource finder
+    * @return flag for the success
+    */
+    bool configure(yarp::os::ResourceFinder &rf);
+
+    /**
+    *  interrupt, e.g., the ports
+    */
+    bool interruptModule();
+
+    /**
+    *  close and shut down the module
+    */
+    bool close();
+
+    /**
+    *  to respond through rpc port
+    * @param command reference to bottle given to rpc port of module, alongwith parameters
+    * @param reply reference to bottle returned by the rpc port in response to command
+    * @return bool flag for the success of response else termination of module
+    */
+    bool respond(const yarp::os::Bottle& command, yarp::os::Bottle& reply);
+
+    /**
+    *  unimplemented
+    */
+    double getPeriod();
+
+    /**
+    *  unimplemented
+    */
+    bool updateModule();
+};
+
+
+#endif // _EXECUTOR_MODULE_H__
+
+//----- end-of-file --- ( next line intentionally left blank ) ------------------
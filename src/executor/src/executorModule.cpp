@@ -0,0 +1,242 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file executorModule.cpp
+ * @brief Implementation of the executorModule (see header file).
+ */
+
+#include "iCub/executorModule.h"
+#include "iCub/iCubeProcessorThread.h"
+#include "iCub/batterySensorThread.h"
+#include "iCub/iCubSimInteractionThread.h"
+#include "iCub/perceptionThread.h"
+#include "iCub/motivationThread.h"
+#include "iCub/decisionMakingThread.h"
+#include "iCub/actionThread.h"
+
+using namespace yarp::os;
+using namespace std;
+
+//order of the cycle: the sensors and the simulated scene, then perception -> motivation -> decision -> action
+static const char* cycleOrder[] = {"iCubeProcessor", "batterySensor", "iCubSimInteraction", "perception", "motivation", "decisionMaking", "action"};
+#define NUMBER_OF_TASKS 7
+
+//outputs read blocking in the cycle (the task waits until they are written again)
+static vector<string> producersOf(const string& module){
+    if(module == "motivation")
+        return {"perception"};                                  //gazeFaceSkin, batteryLevel
+    if(module == "decisionMaking")
+        return {"motivation", "batterySensor"};                 //driveState, noBattery
+    return {};
+}
+
+static bool contains(const Bottle* modules, const string& module){
+    for(int i = 0; i < modules->size(); i++)
+        if(modules->get(i).asString() == module)
+            return true;
+    return false;
+}
+
+//--<module> "(key value) ..." overrides --key of the executor for that module only, e.g. --action "(robot icubSim)"
+static Value moduleOption(ResourceFinder &rf, const string& module, const string& key, const Value& defaultValue){
+    Bottle overrides;
+    if(rf.check(module)){
+        Value& value = rf.find(module);
+        overrides = value.isList() ? *value.asList() : Bottle(value.asString());
+    }
+    return overrides.check(key) ? overrides.find(key) : rf.check(key, defaultValue);
+}
+
+monitoredThread* executorModule::createThread(const string& module, ResourceFinder &rf){
+    string robot = moduleOption(rf, module, "robot", Value(robotName)).asString();
+    string robotColor = moduleOption(rf, module, "robotColor", Value("red")).asString();
+    string robotProfile = moduleOption(rf, module, "robotProfile", Value("social")).asString();
+
+    if(module == "iCubeProcessor"){
+        iCubeProcessorThread* thread = new iCubeProcessorThread(robot, rf, moduleOption(rf, module, "numberICubes", Value(1)).asInt16());
+        thread->setName("/iCubeProcessor");
+        return thread;
+    }
+    if(module == "batterySensor"){
+        batterySensorThread* thread = new batterySensorThread(robot, rf);
+        thread->setName("/batterySensor");
+        return thread;
+    }
+    if(module == "iCubSimInteraction"){
+        iCubSimInteractionThread* thread = new iCubSimInteractionThread(robot, rf);
+        thread->setName("/iCubSimInteraction");
+        return thread;
+    }
+    if(module == "perception"){
+        perceptionThread* thread = new perceptionThread(robot, rf);
+        thread->setName("/perception");
+        return thread;
+    }
+    if(module == "motivation"){
+        motivationThread* thread = new motivationThread(robot, rf, robotColor, robotProfile);
+        thread->setName("/motivation");
+        return thread;
+    }
+    if(module == "decisionMaking"){
+        decisionMakingThread* thread = new decisionMakingThread(robot, rf, robotColor, robotProfile);
+        thread->setName("/decisionMaking");
+        return thread;
+    }
+    if(module == "action"){
+        actionThread* thread = new actionThread(robot, rf, moduleOption(rf, module, "robotPlatform", Value("berry")).asString());
+        thread->setName("/action");
+        return thread;
+    }
+    return nullptr;
+}
+
+bool executorModule::configure(yarp::os::ResourceFinder &rf) {
+    if(rf.check("help")){
+        printf("HELP \n");
+        printf("====== \n");
+        printf("--modules        : modules run in this process (default \"(iCubeProcessor batterySensor perception motivation decisionMaking action)\") \n");
+        printf("--workers        : 1 (decisionMaking in the cycle, its waits delay the others) or 2 (default, decisionMaking on its own worker) \n");
+        printf("--robot, --robotColor, --robotProfile, --robotPlatform, --numberICubes : same as the modules \n");
+        printf("--<module>       : options of one module only, e.g. --action \"(robot icubSim) (robotPlatform icubSim)\" \n");
+        printf(" \n");
+        printf("press CTRL-C to stop... \n");
+        return true;
+    }
+
+    /* get the module name which will form the stem of all module port names */
+    moduleName            = rf.check("name",
+                           Value("/executor"),
+                           "module name (string)").asString();
+    setName(moduleName.c_str());
+
+    robotName             = rf.check("robot",
+                           Value("icub"),
+                           "Robot name (string)").asString();
+
+    handlerPortName =  "";
+    handlerPortName += getName();         // use getName() rather than a literal
+
+    if (!handlerPort.open(handlerPortName.c_str())) {
+        cout << getName() << ": Unable to open port " << handlerPortName << endl;
+        return false;
+    }
+
+    attach(handlerPort);                  // attach to port
+
+    Bottle defaultModules("iCubeProcessor batterySensor perception motivation decisionMaking action");
+    Bottle* modules = rf.check("modules") ? rf.find("modules").asList() : &defaultModules;
+    if(modules == nullptr || modules->size() == 0){
+        yError("--modules needs a list, e.g. \"(perception motivation decisionMaking action)\"");
+        return false;
+    }
+    Bottle allModules;
+    for(int j = 0; j < NUMBER_OF_TASKS; j++)
+        allModules.addString(cycleOrder[j]);
+    for(int i = 0; i < modules->size(); i++){
+        if(!contains(&allModules, modules->get(i).asString())){
+            yError("Unknown module for the executor: %s", modules->get(i).asString().c_str());
+            return false;
+        }
+    }
+
+    int workers = rf.check("workers", Value(2), "1 or 2 (int)").asInt32();
+    if(workers != 1 && workers != 2){
+        yError("--workers must be 1 or 2");
+        return false;
+    }
+
+    /* create the threads in the order of the cycle */
+    pExecutor = new cooperativeExecutor();
+    for(int j = 0; j < NUMBER_OF_TASKS; j++)
+        if(contains(modules, cycleOrder[j])){
+            monitoredThread* thread = createThread(cycleOrder[j], rf);
+            threads.push_back(thread);
+            pExecutor->add(thread, cycleOrder[j], producersOf(cycleOrder[j]), workers == 2 && string(cycleOrder[j]) == "decisionMaking");
+        }
+
+    /* now start the executor to do the work */
+    return pExecutor->start(); // this calls threadInit() of all the modules and it if returns true, it then runs the cycles
+}
+
+bool executorModule::interruptModule() {
+    handlerPort.interrupt();
+    return true;
+}
+
+bool executorModule::close() {
+    handlerPort.close();
+    /* stop the executor */
+    yDebug("stopping the executor \n");
+    if (pExecutor != nullptr){
+        pExecutor->stop();
+        delete pExecutor;
+        pExecutor = nullptr;
+    }
+    for(int i = 0; i < threads.size(); i++)
+        delete threads[i];
+    threads.clear();
+    return true;
+}
+
+bool executorModule::respond(const Bottle& command, Bottle& reply)
+{
+    string helpMessage =  string(getName().c_str()) +
+                " commands are: \n" +
+                "help \n" +
+                "ready : ok when all the modules are running (connections done), wait before \n" +
+                "period : (module period ticks overruns meanUsed maxUsed jitter) for each module, (executor period workers) for the cycle \n" +
+                "quit \n";
+    reply.clear();
+
+    if (command.get(0).asString()=="quit") {
+        reply.addString("quitting");
+        return false;
+    }
+    else if (command.get(0).asString()=="help") {
+        cout << helpMessage;
+        reply.addString("ok");
+    }
+    else if (command.get(0).asString()=="ready") {
+        reply.addString(pExecutor != nullptr && pExecutor->isRunning() ? "ok" : "wait");
+    }
+    else if (command.get(0).asString()=="period" && pExecutor != nullptr) {
+        for(int i = 0; i < pExecutor->getNumberOfTasks(); i++){
+            Bottle& module = reply.addList();
+            module.addString(pExecutor->getTaskName(i));
+            pExecutor->getTask(i)->addPeriodStats(module);
+        }
+        Bottle& cycle = reply.addList();
+        cycle.addString("executor");
+        cycle.addFloat64(pExecutor->getPeriod());
+        cycle.addInt32(pExecutor->getNumberOfWorkers());
+    }
+
+    return true;
+}
+
+/* Called periodically every getPeriod() seconds */
+bool executorModule::updateModule()
+{
+    return true;
+}
+
+double executorModule::getPeriod()
+{
+    /* module periodicity (seconds), called implicitly by myModule */
+    return 1;
+}
@@ -49,7 +49,7 @@ class iCubSimInteractionModule:public yarp::os::RFModule {
     
     yarp::os::Port handlerPort;              // a port to handle messages 
     /*  */
-    iCubSimInteractionThread *pThread;             // pointer to a new thread to be created and started in configure() and stopped in close()
+    iCubSimInteractionThread *pThread = nullptr; // pointer to a new thread to be created and started in configure() and stopped in close()
 
 public:
     /**
@@ -40,8 +40,16 @@
 #include <vector>
 #include <random>
 #include <string.h>
+#include <sstream>
 
-class iCubSimInteractionThread : public yarp::os::PeriodicThread {
+#include "iCub/sceneGenerator.h"
+#include "iCub/csvParser.h"
+#include "iCub/monitoredThread.h"
+
+#define WORLD_RESET_RPC        0   //one blocking RPC per command, waiting for the reply of the simulator
+#define WORLD_RESET_PIPELINED  1   //all the commands of a reset are streamed in order on one connection, without waiting for the replies
+
+class iCubSimInteractionThread : public monitoredThread {
 private:
 
     std::string robot;              // name of the robot
@@ -59,28 +67,31 @@ private:
 
     int episode;
 
-    typedef struct InfoObjectsWorld_{
-        std::string typeObject;
-        float size1;
-        float size2;
-        float size3;
-        float pos1;
-        float pos2;
-        float pos3;
-        int color1;
-        int color2;
-        int color3;
-    }InfoObjectsWorld;
-
     std::vector<InfoObjectsWorld> objectsWorld;
     int totalOjects;
 
+    //Scene cache: commands built once from objectsWorld and reused in every reset
+    std::vector<yarp::os::Bottle> mkObjectsCommands;
+    yarp::os::Bottle delAllCommand;
+    int worldResetMode;
+
+    //Procedural scenes (SCENE_GENERATOR 1): the table of objectsSettings.csv with random objects above it
+    bool useSceneGenerator;
+    sceneGenerator generator;
+    std::vector<worldScene> sceneBank;
+    int sceneBankSize;
+    int nextScene;
+
+    //objects of the episodes not yet written in the file
+    std::ostringstream episodesLog;
+
     std::mt19937 rdx{static_cast<long unsigned int>(21)};
 
     yarp::os::BufferedPort<yarp::os::Bottle> inputPortResetWorld;        //reset simulator when the episode finishes in RL
   
     //Connect to iCub_SIM
     yarp::os::RpcClient rpcWorld;
+    yarp::os::BufferedPort<yarp::os::Bottle> worldStreamPort;          //one way connection to the world port (WORLD_RESET_PIPELINED)
 
     //Turn head angle
     yarp::os::Property options;
@@ -116,7 +127,7 @@ public:
     /**
     *  active part of the thread
     */
-    void run(); 
+    void tick() override;
 
     /**
     * function that sets the rootname of all the ports that are going to be created by the thread
@@ -144,11 +155,13 @@ public:
     bool openAllPorts();
 
     void createObjects();
-    void deletAllObjectsWorld();
-    void addObjectsWorld();
+    void buildWorldCommands();
+    void resetWorld();
+    void sendWorldCommand(const yarp::os::Bottle& command);
     void turnRobotHead();
 
-    void saveObjWorld(int index);
+    void saveObjWorld(const InfoObjectsWorld& object);
+    void flushEpisodesLog();
     void saveHeaders();
     
 };
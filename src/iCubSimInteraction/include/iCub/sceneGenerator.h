@@ -0,0 +1,89 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file sceneGenerator.h
+ * @brief Random scenes of objects on the table of the simulator, generated in banks.
+ */
+
+#ifndef _SCENEGENERATOR_H_
+#define _SCENEGENERATOR_H_
+
+#include <yarp/os/all.h>
+#include <string>
+#include <vector>
+#include <random>
+
+#define SCENE_MAX_ATTEMPTS  50      //positions tried for each object before leaving it out of the scene
+#define SCENE_GAP           0.01    //minimum distance (m) between two objects on the table
+
+//Object of the simulated world (sizes as in the "world mk" command of iCub_SIM, positions in the world frame, y up)
+typedef struct InfoObjectsWorld_{
+    std::string typeObject;
+    float size1;
+    float size2;
+    float size3;
+    float pos1;
+    float pos2;
+    float pos3;
+    int color1;
+    int color2;
+    int color3;
+}InfoObjectsWorld;
+
+//Scene ready to be sent to the simulator: the table, the objects above it and the "world mk" command of each one
+typedef struct worldScene_{
+    std::vector<InfoObjectsWorld> objects;
+    std::vector<yarp::os::Bottle> commands;
+}worldScene;
+
+/**
+* "world mk" command of an object (box: 3 sizes, sph: radius, cyl: radius and length)
+*/
+yarp::os::Bottle makeObjectCommand(const InfoObjectsWorld& object);
+
+/*  Samples scenes for the episodes: number of objects, type, size, color and a position on the table
+    that does not overlap the other objects. Seeded, so the same configuration gives the same sequence of scenes.
+*/
+class sceneGenerator{
+    private:
+        std::mt19937 rng;
+
+        InfoObjectsWorld table;
+        std::vector<std::string> types;
+        std::vector<int> colors;        //r g b of each color
+        float minSize, maxSize;
+        float minX, maxX, minZ, maxZ;   //area of the table where the objects are placed
+        int minObjects, maxObjects;
+
+        float footprint(const InfoObjectsWorld& object);
+        float halfHeight(const InfoObjectsWorld& object);
+
+    public:
+        sceneGenerator();
+
+        /**
+        * read the SCENE_* parameters of the variables group
+        * @param table_ first object of the scene, the objects are placed on its top
+        */
+        bool configure(const yarp::os::Bottle& variables, const InfoObjectsWorld& table_);
+
+        void generateScene(worldScene& scene);
+        void generateBank(int size, std::vector<worldScene>& bank);
+};
+
+#endif  //_SCENEGENERATOR_H_
@@ -32,16 +32,16 @@ using namespace boost;
 
 #define THPERIOD 0.5//s
 
-iCubSimInteractionThread::iCubSimInteractionThread():PeriodicThread(THPERIOD) {
+iCubSimInteractionThread::iCubSimInteractionThread():monitoredThread(THPERIOD) {
     robot = "icub";        
 }
 
-/* iCubSimInteractionThread::iCubSimInteractionThread(string _robot, string _configFile):PeriodicThread(THPERIOD){
+/* iCubSimInteractionThread::iCubSimInteractionThread(string _robot, string _configFile):monitoredThread(THPERIOD){
     robot = _robot;
     configFile = _configFile;
 } */
 
-iCubSimInteractionThread::iCubSimInteractionThread(string _robot,ResourceFinder &_rf):PeriodicThread(THPERIOD){
+iCubSimInteractionThread::iCubSimInteractionThread(string _robot,ResourceFinder &_rf):monitoredThread(THPERIOD){
     robot = _robot;
     rf = _rf;
 }
@@ -73,8 +73,27 @@ bool iCubSimInteractionThread::openAllPorts(){
     
     if(robot.compare("icubSim") == 0){
         //create RPC client and connect it to the world port
-        rpcWorld.open("/iCubSimInteraction/world");
-        Network::connect("/iCubSimInteraction/world", "/icubSim/world");
+        if(worldResetMode == WORLD_RESET_PIPELINED){
+            //strict to keep all the commands of a reset, in order
+            worldStreamPort.setStrict();
+            if(!worldStreamPort.open("/iCubSimInteraction/world:o")){
+                yError("unable to open port to stream the world commands");
+                return false;
+            }
+            if(!Network::connect("/iCubSimInteraction/world:o", "/icubSim/world")){
+                yError("unable to connect to /icubSim/world");
+                return false;
+            }
+        }else{
+            if(!rpcWorld.open("/iCubSimInteraction/world")){
+                yError("unable to open port to send the world commands");
+                return false;
+            }
+            if(!Network::connect("/iCubSimInteraction/world", "/icubSim/world")){
+                yError("unable to connect to /icubSim/world");
+                return false;
+            }
+        }
     }
 
     //create driver for the head
@@ -94,6 +113,8 @@ bool iCubSimInteractionThread::openAllPorts(){
 }
 
 bool iCubSimInteractionThread::threadInit() {
+    configurePeriod(rf.findGroup("periods"), "iCubSimInteraction");
+
     episode = 0;
 
     objectsFilename = rf.find("objectsFilename").asString() + objectsFilename;
@@ -101,6 +122,12 @@ bool iCubSimInteractionThread::threadInit() {
     filepath = rf.find("filepath").asString();
     filename = filepath + filename;
 
+    useSceneGenerator = rf.findGroup("variables").check("SCENE_GENERATOR", Value(0)).asInt32() == 1;
+    sceneBankSize = max(1, rf.findGroup("variables").check("SCENE_BANK_SIZE", Value(100)).asInt32());
+    nextScene = 0;
+
+    worldResetMode = rf.findGroup("variables").check("WORLD_RESET_PIPELINED", Value(WORLD_RESET_PIPELINED)).asInt32() ? WORLD_RESET_PIPELINED : WORLD_RESET_RPC;
+
     saveHeaders();
 
     if(!openAllPorts())
@@ -109,8 +136,19 @@ bool iCubSimInteractionThread::threadInit() {
     //Just add objects in the world if using the simulator
     if(robot.compare("icubSim") == 0){
         createObjects();
-        deletAllObjectsWorld();
-        addObjectsWorld();
+        buildWorldCommands();
+
+        if(useSceneGenerator){
+            if(totalOjects < 1){
+                yError("The scene generator needs the table in %s", objectsFilename.c_str());
+                return false;
+            }
+            if(!generator.configure(rf.findGroup("variables"), objectsWorld[0]))
+                return false;
+            generator.generateBank(sceneBankSize, sceneBank);
+        }
+
+        resetWorld();
     }
     
     yInfo("Initialization of the processing thread correctly ended");
@@ -118,14 +156,13 @@ bool iCubSimInteractionThread::threadInit() {
     return true;
 }
 
-void iCubSimInteractionThread::run(){
+void iCubSimInteractionThread::tick(){
     //reset simulator when the episode finishes in RL. 
     if(inputPortResetWorld.getInputCount()){
         Bottle* readR = inputPortResetWorld.read(false);
         if(readR != nullptr){
             if(robot.compare("icubSim") == 0){//Just add objects in the world if using the simulator
-                deletAllObjectsWorld();
-                addObjectsWorld();
+                resetWorld();
                 episode++;
             }
             //turnRobotHead();
@@ -134,16 +171,25 @@ void iCubSimInteractionThread::run(){
     cout<<"----------------"<<endl;
 }
 
-void iCubSimInteractionThread::saveObjWorld(int index){
-    ofstream fout;
-    fout.open(filename, ios::app);
-    
-    fout << episode << ',' << objectsWorld[index].typeObject << ',' << objectsWorld[index].size1 << ',' << objectsWorld[index].size2 << ',' << objectsWorld[index].size3
-    << ',' << objectsWorld[index].pos1 << ',' << objectsWorld[index].pos2 << ',' << objectsWorld[index].pos3
-    << ',' << objectsWorld[index].color1 << ',' << objectsWorld[index].color2 << ',' << objectsWorld[index].color3;
+void iCubSimInteractionThread::saveObjWorld(const InfoObjectsWorld& object){
+    //kept in memory, written once per reset by flushEpisodesLog
+    ostringstream& fout = episodesLog;
+
+    fout << episode << ',' << object.typeObject << ',' << object.size1 << ',' << object.size2 << ',' << object.size3
+    << ',' << object.pos1 << ',' << object.pos2 << ',' << object.pos3
+    << ',' << object.color1 << ',' << object.color2 << ',' << object.color3;
 
     fout <<"\n";
+}
+
+void iCubSimInteractionThread::flushEpisodesLog(){
+    ofstream fout;
+    fout.open(filename, ios::app);
+    fout << episodesLog.str();
     fout.close();
+
+    episodesLog.str("");
+    episodesLog.clear();
 }
 
 void iCubSimInteractionThread::saveHeaders(){
@@ -156,100 +202,105 @@ void iCubSimInteractionThread::saveHeaders(){
 }
 
 void iCubSimInteractionThread::createObjects(){
-    ifstream fin;
-    fin.open(objectsFilename); 
-    string myline;
-    
-    std::string newObjectInfos[11];
+    csvParser parser;
     InfoObjectsWorld newObject;
 
-    size_t pos;
-    std::string token;
-    std::string delimiter = ",";
-    int i;
-
-    if(fin.is_open()){
-        while(fin){    
-            getline(fin, myline);
-            cout<<myline<<endl;
-            i = 0;
-            pos = 0;
-            while ((pos = myline.find(delimiter)) != std::string::npos){
-                token = myline.substr(0, pos);
-                newObjectInfos[i] = token;
-                std::cout << token << std::endl;
-                myline.erase(0, pos + delimiter.length());
-                i++;
-            }
-            std::cout << myline << std::endl;
-            newObjectInfos[i] = myline;//get the last parameter in the line
-
-            if(i > 0){//just get as objects the lines that contain data in the file
-                newObject.typeObject = newObjectInfos[0];
-                newObject.size1 = stof(newObjectInfos[1]);
-                newObject.size2 = stof(newObjectInfos[2]);
-                newObject.size3 = stof(newObjectInfos[3]);
-                newObject.pos1 = stof(newObjectInfos[4]);
-                newObject.pos2 = stof(newObjectInfos[5]);
-                newObject.pos3 = stof(newObjectInfos[6]);
-                newObject.color1 = stoi(newObjectInfos[7]);
-                newObject.color2 = stoi(newObjectInfos[8]);
-                newObject.color3 = stoi(newObjectInfos[9]);
-
-                objectsWorld.push_back(newObject);
+    if(parser.open(objectsFilename)){
+        //typeObject,size1,size2,size3,pos1,pos2,pos3,color1,color2,color3
+        while(parser.readLine()){
+            parser.expectFields(10);
+            newObject.typeObject = parser.asString(0);
+            newObject.size1 = parser.asFloat(1);
+            newObject.size2 = parser.asFloat(2);
+            newObject.size3 = parser.asFloat(3);
+            newObject.pos1 = parser.asFloat(4);
+            newObject.pos2 = parser.asFloat(5);
+            newObject.pos3 = parser.asFloat(6);
+            newObject.color1 = parser.asInt(7);
+            newObject.color2 = parser.asInt(8);
+            newObject.color3 = parser.asInt(9);
+
+            if(!parser.ok()){
+                yError("%s (object ignored)", parser.getError().c_str());
+                continue;
             }
+            objectsWorld.push_back(newObject);
         }
         cout<<"#objs: "<<objectsWorld.size()<<endl;
     }else
-        cout<<"Couldn't open the "<<objectsFilename<<" file"<<endl;
+        cout<<parser.getError()<<endl;
 
     totalOjects = objectsWorld.size();
 }
 
-void iCubSimInteractionThread::addObjectsWorld(){
+void iCubSimInteractionThread::buildWorldCommands(){
+    delAllCommand.clear();
+    delAllCommand.addString("world");
+    delAllCommand.addString("del");
+    delAllCommand.addString("all");
+
+    mkObjectsCommands.clear();
+    for(int i = 0; i < totalOjects; i++)
+        mkObjectsCommands.push_back(makeObjectCommand(objectsWorld[i]));
+}
+
+void iCubSimInteractionThread::sendWorldCommand(const Bottle& command){
+    if(worldResetMode == WORLD_RESET_PIPELINED){
+        //strict write: waits for the previous command instead of replacing it while it is being sent
+        worldStreamPort.prepare() = command;
+        worldStreamPort.write(true);
+        return;
+    }
+
+    //make RPC call
     Bottle response;
-    //prepare command for RPC
-    Bottle addObjInWorld;
+    rpcWorld.write(command, response);
+    cout<<command.toString()<<": "<<response.toString()<<endl;
+}
+
+void iCubSimInteractionThread::resetWorld(){
+    if(useSceneGenerator){
+        //all the scenes of the bank were used, generate the next ones
+        if(nextScene == sceneBank.size()){
+            generator.generateBank(sceneBankSize, sceneBank);
+            nextScene = 0;
+        }
+        worldScene& scene = sceneBank[nextScene++];
+
+        sendWorldCommand(delAllCommand);
+        for(int i = 0; i < scene.commands.size(); i++){
+            sendWorldCommand(scene.commands[i]);
+            saveObjWorld(scene.objects[i]);
+        }
+        if(worldResetMode == WORLD_RESET_PIPELINED)
+            worldStreamPort.waitForWrite();
+
+        cout<<"World reset with the generated scene "<<nextScene - 1<<" ("<<scene.objects.size() - 1<<" objects)"<<endl;
+        flushEpisodesLog();
+        return;
+    }
+
+    if(totalOjects < 2){
+        yError("The scene needs the table and at least one object (%s)", objectsFilename.c_str());
+        return;
+    }
 
     //Desconsider the first object (table)
     std::uniform_int_distribution<int> distrObjcs(1, totalOjects-1);
     int objsInScene = distrObjcs(rdx);
 
+    sendWorldCommand(delAllCommand);
     for(int i = 0; i < objsInScene + 1; i++){//+1 because add the table + objects above the table (randomly amount)
-        addObjInWorld.clear();
-        addObjInWorld.addString("world");
-        addObjInWorld.addString("mk");
-        addObjInWorld.addString(objectsWorld[i].typeObject);//box, sbox, sph, ssph, cyl, scyl (s-xxx is for static objects)
-        addObjInWorld.addFloat64(objectsWorld[i].size1);
-        addObjInWorld.addFloat64(objectsWorld[i].size2);
-        addObjInWorld.addFloat64(objectsWorld[i].size3);
-        addObjInWorld.addFloat64(objectsWorld[i].pos1);
-        addObjInWorld.addFloat64(objectsWorld[i].pos2);
-        addObjInWorld.addFloat64(objectsWorld[i].pos3);
-        addObjInWorld.addInt32(objectsWorld[i].color1);
-        addObjInWorld.addInt32(objectsWorld[i].color2);
-        addObjInWorld.addInt32(objectsWorld[i].color3);
-        cout<<addObjInWorld.toString()<<endl;
-        //make RPC call
-        response.clear();
-        rpcWorld.write(addObjInWorld, response);
-        cout<<"Adding object: "<<response.toString()<<endl;
-
-        saveObjWorld(i);
+        sendWorldCommand(mkObjectsCommands[i]);
+        saveObjWorld(objectsWorld[i]);
     }
-}
 
-void iCubSimInteractionThread::deletAllObjectsWorld(){
-    //prepare command for RPC
-    Bottle worldDelAll;
-    worldDelAll.addString("world");
-    worldDelAll.addString("del");
-    worldDelAll.addString("all");
+    //all the commands were queued, wait until they are sent
+    if(worldResetMode == WORLD_RESET_PIPELINED)
+        worldStreamPort.waitForWrite();
 
-    //make RPC call
-    Bottle response;
-    rpcWorld.write(worldDelAll, response);
-    cout<<"Deleting all objects: "<<response.toString()<<endl;
+    cout<<"World reset with "<<objsInScene<<" objects"<<endl;
+    flushEpisodesLog();
 }
 
 void iCubSimInteractionThread::turnRobotHead(){
@@ -288,4 +339,7 @@ bool iCubSimInteractionThread::processing(){
 void iCubSimInteractionThread::threadRelease() {
     inputPortResetWorld.interrupt();
     inputPortResetWorld.close();
+
+    worldStreamPort.interrupt();
+    worldStreamPort.close();
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file sceneGenerator.cpp
+ * @brief Implementation of the scene generator (see sceneGenerator.h).
+ */
+
+#include "iCub/sceneGenerator.h"
+#include <cmath>
+
+using namespace yarp::os;
+using namespace std;
+
+//box, sph or cyl (s-xxx is for static objects)
+static string shapeOf(const string& type){
+    if(type.size() == 4 && type[0] == 's')
+        return type.substr(1);
+    return type;
+}
+
+Bottle makeObjectCommand(const InfoObjectsWorld& object){
+    Bottle command;
+    command.addString("world");
+    command.addString("mk");
+    command.addString(object.typeObject);
+
+    string shape = shapeOf(object.typeObject);
+    command.addFloat64(object.size1);
+    if(shape != "sph")
+        command.addFloat64(object.size2);
+    if(shape == "box")
+        command.addFloat64(object.size3);
+
+    command.addFloat64(object.pos1);
+    command.addFloat64(object.pos2);
+    command.addFloat64(object.pos3);
+    command.addInt32(object.color1);
+    command.addInt32(object.color2);
+    command.addInt32(object.color3);
+    return command;
+}
+
+sceneGenerator::sceneGenerator(){
+    minSize = maxSize = 0.0;
+    minX = maxX = minZ = maxZ = 0.0;
+    minObjects = maxObjects = 0;
+}
+
+bool sceneGenerator::configure(const Bottle& variables, const InfoObjectsWorld& table_){
+    table = table_;
+    rng.seed(variables.check("SCENE_SEED", Value(21)).asInt32());
+    minObjects = variables.check("SCENE_MIN_OBJECTS", Value(1)).asInt32();
+    maxObjects = variables.check("SCENE_MAX_OBJECTS", Value(3)).asInt32();
+
+    Bottle* typesList = variables.find("SCENE_TYPES").asList();
+    Bottle* sizeList = variables.find("SCENE_SIZE").asList();
+    Bottle* areaList = variables.find("SCENE_AREA").asList();
+    Bottle* colorsList = variables.find("SCENE_COLORS").asList();
+    if(typesList == nullptr || sizeList == nullptr || areaList == nullptr || colorsList == nullptr
+       || typesList->size() == 0 || sizeList->size() != 2 || areaList->size() != 4 || colorsList->size() == 0){
+        yError("SCENE_TYPES, SCENE_SIZE (min max), SCENE_AREA (minX maxX minZ maxZ) and SCENE_COLORS ((r g b) ...) are needed to generate scenes");
+        return false;
+    }
+    if(minObjects < 0 || maxObjects < minObjects){
+        yError("SCENE_MIN_OBJECTS must be >= 0 and <= SCENE_MAX_OBJECTS");
+        return false;
+    }
+
+    types.clear();
+    for(int i = 0; i < typesList->size(); i++){
+        string shape = shapeOf(typesList->get(i).asString());
+        if(shape != "box" && shape != "sph" && shape != "cyl"){
+            yError("Unknown object type in SCENE_TYPES: %s", typesList->get(i).asString().c_str());
+            return false;
+        }
+        types.push_back(typesList->get(i).asString());
+    }
+
+    minSize = sizeList->get(0).asFloat64();
+    maxSize = sizeList->get(1).asFloat64();
+    minX = areaList->get(0).asFloat64();
+    maxX = areaList->get(1).asFloat64();
+    minZ = areaList->get(2).asFloat64();
+    maxZ = areaList->get(3).asFloat64();
+
+    colors.clear();
+    for(int i = 0; i < colorsList->size(); i++){
+        Bottle* color = colorsList->get(i).asList();
+        if(color == nullptr || color->size() != 3){
+            yError("Each color in SCENE_COLORS must be (r g b)");
+            return false;
+        }
+        for(int c = 0; c < 3; c++)
+            colors.push_back(color->get(c).asInt32());
+    }
+
+    return true;
+}
+
+//radius of the circle that contains the object seen from above
+float sceneGenerator::footprint(const InfoObjectsWorld& object){
+    if(shapeOf(object.typeObject) == "box")
+        return 0.5 * sqrt(object.size1 * object.size1 + object.size3 * object.size3);
+    return object.size1;
+}
+
+float sceneGenerator::halfHeight(const InfoObjectsWorld& object){
+    if(shapeOf(object.typeObject) == "sph")
+        return object.size1;
+    return 0.5 * object.size2;  //box height and cyl length
+}
+
+void sceneGenerator::generateScene(worldScene& scene){
+    uniform_int_distribution<int> distrObjects(minObjects, maxObjects);
+    uniform_int_distribution<int> distrType(0, types.size() - 1);
+    uniform_int_distribution<int> distrColor(0, colors.size() / 3 - 1);
+    uniform_real_distribution<float> distrSize(minSize, maxSize);
+    uniform_real_distribution<float> distrX(minX, maxX);
+    uniform_real_distribution<float> distrZ(minZ, maxZ);
+
+    float tableTop = table.pos2 + 0.5 * table.size2;
+
+    scene.objects.clear();
+    scene.commands.clear();
+    scene.objects.push_back(table);
+
+    int objsInScene = distrObjects(rng);
+    for(int i = 0; i < objsInScene; i++){
+        InfoObjectsWorld newObject;
+        newObject.typeObject = types[distrType(rng)];
+
+        string shape = shapeOf(newObject.typeObject);
+        newObject.size1 = shape == "box" ? distrSize(rng) : 0.5 * distrSize(rng);  //radius for sph and cyl
+        newObject.size2 = distrSize(rng);
+        newObject.size3 = shape == "box" ? distrSize(rng) : 0.0;
+
+        int color = distrColor(rng);
+        newObject.color1 = colors[3 * color];
+        newObject.color2 = colors[3 * color + 1];
+        newObject.color3 = colors[3 * color + 2];
+
+        //rejection sampling of the position, the object is left out if there is no free place
+        float radius = footprint(newObject);
+        bool placed = false;
+        for(int attempt = 0; attempt < SCENE_MAX_ATTEMPTS && !placed; attempt++){
+            newObject.pos1 = distrX(rng);
+            newObject.pos3 = distrZ(rng);
+            placed = true;
+            for(int j = 1; j < scene.objects.size() && placed; j++){
+                float dx = newObject.pos1 - scene.objects[j].pos1;
+                float dz = newObject.pos3 - scene.objects[j].pos3;
+                float minDistance = radius + footprint(scene.objects[j]) + SCENE_GAP;
+                placed = dx * dx + dz * dz >= minDistance * minDistance;
+            }
+        }
+        if(!placed)
+            continue;
+
+        newObject.pos2 = tableTop + halfHeight(newObject);
+        scene.objects.push_back(newObject);
+    }
+
+    for(int i = 0; i < scene.objects.size(); i++)
+        scene.commands.push_back(makeObjectCommand(scene.objects[i]));
+}
+
+void sceneGenerator::generateBank(int size, vector<worldScene>& bank){
+    bank.resize(size);
+    for(int i = 0; i < size; i++)
+        generateScene(bank[i]);
+}
@@ -0,0 +1,81 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file iCubeImu.h
+ * @brief Buffers of the IMU samples of the iCubes and detection of free falls and throws.
+ */
+
+#ifndef _ICUBEIMU_H_
+#define _ICUBEIMU_H_
+
+#define IMU_BUFFER_SIZE 128     //samples kept for each cube (must hold all the samples received in one step)
+
+#define FREE_FALL_RATIO 0.3     //free fall when |acceleration| < FREE_FALL_RATIO * gravity
+#define THROW_RATIO     2.0     //thrown when there is a free fall and |acceleration| > THROW_RATIO * gravity in the same step
+#define REST_RATIO      0.1     //samples with ||acceleration| - gravity| < REST_RATIO * gravity are used to estimate the gravity
+#define GRAVITY_ALPHA   0.05    //low pass filter of the gravity estimation (the gravity is in the units of the iCube)
+
+//Ring buffer with the IMU samples of one cube (structure-of-arrays)
+typedef struct iCubeImuBuffer_{
+    double accX[IMU_BUFFER_SIZE], accY[IMU_BUFFER_SIZE], accZ[IMU_BUFFER_SIZE];
+    double quatW[IMU_BUFFER_SIZE], quatX[IMU_BUFFER_SIZE], quatY[IMU_BUFFER_SIZE], quatZ[IMU_BUFFER_SIZE];
+    double time[IMU_BUFFER_SIZE];
+    int head;       //position of the next sample
+    int samples;    //samples received since the last step (at most IMU_BUFFER_SIZE, the older ones are lost)
+}iCubeImuBuffer;
+
+//Samples of one step in order (oldest first), same layout of the buffer
+typedef struct iCubeImuWindow_{
+    double accX[IMU_BUFFER_SIZE], accY[IMU_BUFFER_SIZE], accZ[IMU_BUFFER_SIZE];
+    double quatW[IMU_BUFFER_SIZE], quatX[IMU_BUFFER_SIZE], quatY[IMU_BUFFER_SIZE], quatZ[IMU_BUFFER_SIZE];
+    double time[IMU_BUFFER_SIZE];
+    int samples;
+}iCubeImuWindow;
+
+//Features of one step of one cube
+typedef struct iCubeImuFeatures_{
+    int samples;                //samples used to compute the features
+    double shakeEnergy;         //variance of the acceleration
+    double rotationRate;        //mean angular speed (rad/s)
+    double orientationChange;   //angle (rad) between the orientation at the end of the last step and the current one
+    int freeFall;               //1 if the cube was falling
+    int thrown;                 //1 if the cube was thrown (high acceleration and free fall in the same step)
+}iCubeImuFeatures;
+
+//State kept between steps to compute the features of one cube
+typedef struct iCubeImuHistory_{
+    double lastQuaternion[4];   //w x y z, all 0 before the first sample
+    double gravity;             //magnitude of the acceleration at rest, 0 before the first sample
+}iCubeImuHistory;
+
+void initImuBuffer(iCubeImuBuffer& buffer);
+void initImuHistory(iCubeImuHistory& history);
+
+/**
+* add one sample to the ring buffer (quaternion w x y z)
+*/
+void pushImuSample(iCubeImuBuffer& buffer, const double quaternion[4], const double acceleration[3], double time);
+
+/**
+* move the samples received since the last step to the window
+*/
+void takeImuWindow(iCubeImuBuffer& buffer, iCubeImuWindow& window);
+
+void computeImuFeatures(const iCubeImuWindow& window, iCubeImuHistory& history, iCubeImuFeatures& features);
+
+#endif  //_ICUBEIMU_H_
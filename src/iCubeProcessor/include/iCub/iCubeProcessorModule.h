@@ -49,7 +49,7 @@ class iCubeProcessorModule:public yarp::os::RFModule {
     
     yarp::os::Port handlerPort;              // a port to handle messages 
     /*  */
-    iCubeProcessorThread *pThread;             // pointer to a new thread to be created and started in configure() and stopped in close()
+    iCubeProcessorThread *pThread = nullptr; // pointer to a new thread to be created and started in configure() and stopped in close()
 
     int numberOfICubes;
     
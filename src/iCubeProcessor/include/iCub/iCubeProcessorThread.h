@@ -41,10 +41,10 @@
 #include <random>
 #include <string.h>
 
-#define NO_DATA -1
-#define NO_CONNECTION -2
+#include "iCub/iCubeReader.h"
+#include "iCub/monitoredThread.h"
 
-class iCubeProcessorThread : public yarp::os::PeriodicThread {
+class iCubeProcessorThread : public monitoredThread {
 private:
 
     std::string robot;              // name of the robot
@@ -56,30 +56,34 @@ private:
 
     std::string filepath;
     std::string filename = "iCubeProcessor.csv";
-    std::string fileHeader = "time,durationExp,iCubeNumber,numberFacesTouched,face_0,face_1,face_2,face_3,face_4,face_5,pose";
+    std::string fileHeader = "time,durationExp,iCubeNumber,status,touchMask,numberFacesTouched,pose";
 
     time_t now;
     std::string timeNow;
     std::time_t timeInitial;
 
-    std::vector<std::string> touchesFace_raw;
-    yarp::os::Bottle facesBeingTouched;
-    std::vector<double> quaternions,accelerations;
-    std::string pose;
-
-    yarp::os::Bottle dataCube;
-    yarp::os::Bottle dataAllCubes;
-
-    //First steps to try to have more than one cube
     int numberOfICubes;
     std::string dataPortNamePrefix = "/iCubeData_";
     std::string eventPortNamePrefix = "/iCubeEvents_";
-    std::vector<yarp::os::BufferedPort<yarp::os::Bottle>*> inputICubesDataPorts;
-    std::vector<yarp::os::BufferedPort<yarp::os::Bottle>*> inputICubesEventsPorts;
+    std::vector<iCubeReader*> inputICubesDataPorts;     //decode the data of each cube in its callback
+    std::vector<iCubeReader*> inputICubesEventsPorts;
+
+    iCubeSlot* cubes;                   //state of each cube, written by the callbacks
+    iCubePoseTable poseTable;
+
+    //Copy of the state of all the cubes at each step
+    std::vector<iCubeState> cubesSnapshot;
+    std::vector<int> cubesStatus;       //ICUBE_OK, NO_DATA or NO_CONNECTION
+    std::vector<unsigned int> cubesTouchMask;   //0 if the status is not ICUBE_OK
+    std::vector<std::string> cubesPose;
+
+    //IMU features of each cube computed at each step with all the samples received
+    iCubeImuWindow imuWindow;
+    std::vector<iCubeImuHistory> imuHistory;
+    std::vector<iCubeImuFeatures> imuFeatures;
 
-    
-   
     yarp::os::BufferedPort<yarp::os::Bottle> outputICubeDataPort;
+    yarp::os::BufferedPort<yarp::os::Bottle> outputICubeFeaturesPort;     //(samples shakeEnergy rotationRate orientationChange freeFall thrown) of each cube
     
 public:
     /**
@@ -111,7 +115,7 @@ public:
     /**
     *  active part of the thread
     */
-    void run(); 
+    void tick() override;
 
     /**
     * function that sets the rootname of all the ports that are going to be created by the thread
@@ -143,10 +147,8 @@ public:
 
     void readICube();
     void printDataAlliCubes();
-    void resetStructures();
     void sendToPerception();
-    void processICubeData(yarp::os::Bottle* bottleCubeData);
-    void processICubeEvent(yarp::os::Bottle* bottleCubeEvents);
+    void sendImuFeatures();
 };
 
 #endif  //_ICUBEPROCESSOR_PERIODTHREAD_H_
@@ -0,0 +1,81 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file iCubeReader.h
+ * @brief Port callbacks that keep the last state of each iCube, read by the processor at each step.
+ */
+
+#ifndef _ICUBEREADER_H_
+#define _ICUBEREADER_H_
+
+#include <yarp/os/all.h>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "iCub/iCubeImu.h"
+#include "iCub/iCubeTouch.h"
+
+#define NO_POSE -1
+
+#define ICUBE_DATA_READER   0   //quaternion, 6 faces touch, acceleration
+#define ICUBE_EVENTS_READER 1   //pose
+
+//Fixed layout state of one iCube, filled by the port callbacks
+typedef struct iCubeState_{
+    double quaternion[4];
+    double acceleration[3];
+    unsigned int touchMask;     //bit i is 1 if the face i is being touched
+    int pose;                   //index in the table of poses (NO_POSE if no pose event since the last reading)
+    bool newData;               //data received since the last reading
+}iCubeState;
+
+//State of one iCube, all its IMU samples since the last reading and the mutex shared by its data and events callbacks
+typedef struct iCubeSlot_{
+    std::mutex stateMutex;
+    iCubeState state;
+    iCubeImuBuffer imu;
+}iCubeSlot;
+
+//Table shared by all the cubes to represent the poses (strings sent by the iCube) as integers
+class iCubePoseTable{
+    private:
+        std::mutex tableMutex;
+        std::vector<std::string> poses;
+    public:
+        int getIndex(const std::string& pose);
+        std::string getPose(int index);
+};
+
+/*  Port that decodes each message of the iCube straight into its iCubeState (in the YARP reader thread),
+    so the periodic thread just copies the state of each cube
+*/
+class iCubeReader : public yarp::os::BufferedPort<yarp::os::Bottle>{
+    private:
+        iCubeSlot* slot;
+        iCubePoseTable* poseTable;
+        int readerType;
+
+    public:
+        iCubeReader(iCubeSlot* slot_, iCubePoseTable* poseTable_, int readerType_);
+
+        using yarp::os::BufferedPort<yarp::os::Bottle>::onRead;
+        void onRead(yarp::os::Bottle& bottleCube) override;
+};
+
+#endif  //_ICUBEREADER_H_
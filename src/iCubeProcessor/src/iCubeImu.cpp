@@ -0,0 +1,148 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file iCubeImu.cpp
+ * @brief Implementation of the IMU processing of the iCubes (see iCubeImu.h).
+ */
+
+#include "iCub/iCubeImu.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+void initImuBuffer(iCubeImuBuffer& buffer){
+    buffer.head = 0;
+    buffer.samples = 0;
+}
+
+void initImuHistory(iCubeImuHistory& history){
+    for(int i = 0; i < 4; i++)
+        history.lastQuaternion[i] = 0.0;
+    history.gravity = 0.0;
+}
+
+void pushImuSample(iCubeImuBuffer& buffer, const double quaternion[4], const double acceleration[3], double time){
+    int i = buffer.head;
+    buffer.quatW[i] = quaternion[0];
+    buffer.quatX[i] = quaternion[1];
+    buffer.quatY[i] = quaternion[2];
+    buffer.quatZ[i] = quaternion[3];
+    buffer.accX[i] = acceleration[0];
+    buffer.accY[i] = acceleration[1];
+    buffer.accZ[i] = acceleration[2];
+    buffer.time[i] = time;
+
+    buffer.head = (buffer.head + 1) % IMU_BUFFER_SIZE;
+    buffer.samples = min(buffer.samples + 1, IMU_BUFFER_SIZE);
+}
+
+void takeImuWindow(iCubeImuBuffer& buffer, iCubeImuWindow& window){
+    int n = buffer.samples;
+    int first = (buffer.head - n + IMU_BUFFER_SIZE) % IMU_BUFFER_SIZE;
+
+    //two contiguous blocks: [first, end of the buffer) and [0, head)
+    int firstBlock = min(n, IMU_BUFFER_SIZE - first);
+    const double* from[8] = {buffer.accX, buffer.accY, buffer.accZ, buffer.quatW, buffer.quatX, buffer.quatY, buffer.quatZ, buffer.time};
+    double* to[8] = {window.accX, window.accY, window.accZ, window.quatW, window.quatX, window.quatY, window.quatZ, window.time};
+    for(int k = 0; k < 8; k++){
+        copy(from[k] + first, from[k] + first + firstBlock, to[k]);
+        copy(from[k], from[k] + (n - firstBlock), to[k] + firstBlock);
+    }
+
+    window.samples = n;
+    buffer.samples = 0;
+}
+
+//angle (rad) between two orientations
+static double quaternionAngle(double w0, double x0, double y0, double z0, double w1, double x1, double y1, double z1){
+    double norms = sqrt((w0*w0 + x0*x0 + y0*y0 + z0*z0) * (w1*w1 + x1*x1 + y1*y1 + z1*z1));
+    if(norms <= 0.0)
+        return 0.0;
+    double dot = fabs(w0*w1 + x0*x1 + y0*y1 + z0*z1) / norms;
+    return 2.0 * acos(min(dot, 1.0));
+}
+
+/*  The loops over the samples have no dependencies between iterations (except the gravity filter),
+    so the compiler can vectorize them
+*/
+void computeImuFeatures(const iCubeImuWindow& window, iCubeImuHistory& history, iCubeImuFeatures& features){
+    const int n = window.samples;
+    features.samples = n;
+    features.shakeEnergy = 0.0;
+    features.rotationRate = 0.0;
+    features.orientationChange = 0.0;
+    features.freeFall = 0;
+    features.thrown = 0;
+
+    if(n == 0)
+        return;
+
+    //acceleration magnitude and mean
+    double magnitude[IMU_BUFFER_SIZE];
+    double sumX = 0.0, sumY = 0.0, sumZ = 0.0, sumMagnitude = 0.0;
+    for(int i = 0; i < n; i++){
+        magnitude[i] = sqrt(window.accX[i] * window.accX[i] + window.accY[i] * window.accY[i] + window.accZ[i] * window.accZ[i]);
+        sumX += window.accX[i];
+        sumY += window.accY[i];
+        sumZ += window.accZ[i];
+        sumMagnitude += magnitude[i];
+    }
+    double meanX = sumX / n, meanY = sumY / n, meanZ = sumZ / n;
+
+    //shake energy: variance of the acceleration
+    double energy = 0.0;
+    for(int i = 0; i < n; i++){
+        double dx = window.accX[i] - meanX, dy = window.accY[i] - meanY, dz = window.accZ[i] - meanZ;
+        energy += dx * dx + dy * dy + dz * dz;
+    }
+    features.shakeEnergy = energy / n;
+
+    //gravity: magnitude of the acceleration when the cube is not moving (units of the iCube)
+    if(history.gravity <= 0.0)
+        history.gravity = sumMagnitude / n;
+    for(int i = 0; i < n; i++)
+        if(fabs(magnitude[i] - history.gravity) < REST_RATIO * history.gravity)
+            history.gravity += GRAVITY_ALPHA * (magnitude[i] - history.gravity);
+
+    //free fall and throw
+    int fallingSamples = 0;
+    double maxMagnitude = 0.0;
+    for(int i = 0; i < n; i++){
+        fallingSamples += magnitude[i] < FREE_FALL_RATIO * history.gravity;
+        maxMagnitude = max(maxMagnitude, magnitude[i]);
+    }
+    features.freeFall = fallingSamples > 0;
+    features.thrown = features.freeFall && maxMagnitude > THROW_RATIO * history.gravity;
+
+    //rotation rate between consecutive samples
+    double rotation = 0.0;
+    for(int i = 1; i < n; i++)
+        rotation += quaternionAngle(window.quatW[i-1], window.quatX[i-1], window.quatY[i-1], window.quatZ[i-1], window.quatW[i], window.quatX[i], window.quatY[i], window.quatZ[i]);
+    double duration = window.time[n-1] - window.time[0];
+    if(duration > 0.0)
+        features.rotationRate = rotation / duration;
+
+    //orientation change since the last step
+    features.orientationChange = quaternionAngle(history.lastQuaternion[0], history.lastQuaternion[1], history.lastQuaternion[2], history.lastQuaternion[3],
+                                                 window.quatW[n-1], window.quatX[n-1], window.quatY[n-1], window.quatZ[n-1]);
+    history.lastQuaternion[0] = window.quatW[n-1];
+    history.lastQuaternion[1] = window.quatX[n-1];
+    history.lastQuaternion[2] = window.quatY[n-1];
+    history.lastQuaternion[3] = window.quatZ[n-1];
+}
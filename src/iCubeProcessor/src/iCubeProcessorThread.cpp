@@ -34,18 +34,21 @@ using namespace boost;
 
 #define THPERIOD 0.5//s
 
-iCubeProcessorThread::iCubeProcessorThread():PeriodicThread(THPERIOD) {
+iCubeProcessorThread::iCubeProcessorThread():monitoredThread(THPERIOD) {
     robot = "icub";   
+    numberOfICubes = 0;
+    cubes = nullptr;
 }
 
-iCubeProcessorThread::iCubeProcessorThread(string _robot, ResourceFinder &_rf, int _numberOfICubes):PeriodicThread(THPERIOD){
+iCubeProcessorThread::iCubeProcessorThread(string _robot, ResourceFinder &_rf, int _numberOfICubes):monitoredThread(THPERIOD){
     robot = _robot;
     rf = _rf;
     numberOfICubes = _numberOfICubes;
+    cubes = nullptr;
 }
 
 iCubeProcessorThread::~iCubeProcessorThread() {
-
+    delete [] cubes;
 }
 
 void iCubeProcessorThread::setName(string str) {
@@ -68,10 +71,13 @@ bool iCubeProcessorThread::openAllPorts(){
 
     /* ======================== Input ========================*/
     for (int i = 0; i < numberOfICubes; i++){
-        BufferedPort<Bottle>* dataPort;
-        BufferedPort<Bottle>* eventPort;
-        dataPort = new BufferedPort<Bottle>;
-        eventPort = new BufferedPort<Bottle>;
+        iCubeReader* dataPort;
+        iCubeReader* eventPort;
+        dataPort = new iCubeReader(&cubes[i], &poseTable, ICUBE_DATA_READER);
+        eventPort = new iCubeReader(&cubes[i], &poseTable, ICUBE_EVENTS_READER);
+        dataPort->useCallback();
+        dataPort->setStrict();//all the samples are used to compute the IMU features
+        eventPort->useCallback();
 
         string name_temp = dataPortNamePrefix + to_string(i) + ":i";
         if(!dataPort->open(getName(name_temp.c_str()).c_str())) {
@@ -96,16 +102,39 @@ bool iCubeProcessorThread::openAllPorts(){
         return false;  // unable to open; let RFModule know so that it won't run
     }
 
+    if(!outputICubeFeaturesPort.open(getName("/iCubeFeatures:o").c_str())) {
+        yError("unable to open port to send iCube IMU features ");
+        return false;  // unable to open; let RFModule know so that it won't run
+    }
+
     yDebug("Everything opened!");
 
     return true;
 }
 
 bool iCubeProcessorThread::threadInit() {
+    configurePeriod(rf.findGroup("periods"), "iCubeProcessor");
+
     filepath = rf.find("filepath").asString();
     filename = filepath + filename;
 
     saveHeaders();
+
+    //preallocate the state of all the cubes
+    cubes = new iCubeSlot[numberOfICubes];
+    for(int i = 0; i < numberOfICubes; i++){
+        cubes[i].state = iCubeState();
+        cubes[i].state.pose = NO_POSE;
+        initImuBuffer(cubes[i].imu);
+    }
+    cubesSnapshot.resize(numberOfICubes);
+    cubesStatus.resize(numberOfICubes);
+    cubesTouchMask.resize(numberOfICubes);
+    cubesPose.resize(numberOfICubes);
+    imuHistory.resize(numberOfICubes);
+    imuFeatures.resize(numberOfICubes);
+    for(int i = 0; i < numberOfICubes; i++)
+        initImuHistory(imuHistory[i]);
    
     if(!openAllPorts())
         return false;
@@ -117,7 +146,7 @@ bool iCubeProcessorThread::threadInit() {
     return true;
 }
 
-void iCubeProcessorThread::run(){
+void iCubeProcessorThread::tick(){
     /************************************ Time related -> just for saving stuff ************************************/
     now = time(0);
     char* timeNow_ = ctime(&now);
@@ -130,106 +159,78 @@ void iCubeProcessorThread::run(){
     printDataAlliCubes();
     
     sendToPerception();
+    sendImuFeatures();
 
     save();
-
-    dataAllCubes.clear();
     
     cout <<"-------------------------------------------------------"<<endl;
 }
 
-void iCubeProcessorThread::processICubeData(Bottle* bottleCubeData){
-    int touchedFaces = 0;
-
-    if(bottleCubeData->size()){
-        quaternions = {bottleCubeData->get(0).asFloat64(), bottleCubeData->get(1).asFloat64(),bottleCubeData->get(2).asFloat64(), bottleCubeData->get(3).asFloat64()};
-        touchesFace_raw = {bottleCubeData->get(4).asString(), bottleCubeData->get(5).asString(), bottleCubeData->get(6).asString(), bottleCubeData->get(7).asString(), bottleCubeData->get(8).asString(), bottleCubeData->get(9).asString()};
-        accelerations = {bottleCubeData->get(10).asFloat64(),bottleCubeData->get(11).asFloat64(), bottleCubeData->get(12).asFloat64()};
-    
-        for(int i = 0; i < touchesFace_raw.size(); i++)
-            if(touchesFace_raw[i].find("1") != std::string::npos){
-                touchedFaces += 1;
-                facesBeingTouched.addInt32(1);
-            }else
-                facesBeingTouched.addInt32(0);
-
-        dataCube.addInt32(touchedFaces);
-        dataCube.addList() = facesBeingTouched;
-    }
-}
-
-void iCubeProcessorThread::processICubeEvent(Bottle* bottleCubeEvents){
-    if(bottleCubeEvents->size()){
-        pose = bottleCubeEvents->get(0).asString();
-        dataCube.addString(pose);
-    }
-}
-
-void iCubeProcessorThread::resetStructures(){
-    pose.clear();
-    touchesFace_raw.clear();
-    quaternions.clear();
-    accelerations.clear();
-    facesBeingTouched.clear();
-    dataCube.clear();
-}
-
+//Copy the state decoded by the callbacks. A cube without new data since the last step is NO_DATA (different from receiving data with 0 faces touched)
 void iCubeProcessorThread::readICube(){
-     for(int i = 0; i < numberOfICubes; i++){
-        resetStructures();
-        cout<<i<<endl;
-        //Data related
-        if(inputICubesDataPorts[i]->getInputCount()){
-            Bottle* bottleCubeData = NULL;
-            bottleCubeData = inputICubesDataPorts[i]->read(false);//used false because if one cube lose connection the module remains blocked until the cube connects again
-
-            if(bottleCubeData != NULL)
-                processICubeData(bottleCubeData);
-            else{
-                cout<<"iCube_"<<i<<" DID NOT send data"<<endl;
-                dataCube.addInt32(NO_DATA);//Means that didnt receive data from cube in that reading (it is different from receiving data with 0 faces touched)
-                dataCube.addList() = facesBeingTouched;
-            }
-        }else{
-            cout<<"iCube_"<<i<<" not connected"<<endl;
-            dataCube.addInt32(NO_CONNECTION);//Means that iCube_x is not connected
-            dataCube.addList() = facesBeingTouched;
+    for(int i = 0; i < numberOfICubes; i++){
+        {
+            lock_guard<mutex> lock(cubes[i].stateMutex);
+            cubesSnapshot[i] = cubes[i].state;
+            cubes[i].state.newData = false;
+            cubes[i].state.pose = NO_POSE;//the pose is sent just when there is a new movement
+            takeImuWindow(cubes[i].imu, imuWindow);
         }
 
-        //Events related
-        if(inputICubesEventsPorts[i]->getInputCount()){
-            Bottle* bottleCubeEvents = NULL;
-            bottleCubeEvents = inputICubesEventsPorts[i]->read(false);//send data just when there is a new movement (sometimes lose the reading due time issues)
+        computeImuFeatures(imuWindow, imuHistory[i], imuFeatures[i]);
 
-            if(bottleCubeEvents != NULL)
-                processICubeEvent(bottleCubeEvents);
-        }
+        if(inputICubesDataPorts[i]->getInputCount() == 0)
+            cubesStatus[i] = NO_CONNECTION;
+        else if(!cubesSnapshot[i].newData)
+            cubesStatus[i] = NO_DATA;
+        else
+            cubesStatus[i] = ICUBE_OK;
+        cubesTouchMask[i] = cubesStatus[i] == ICUBE_OK ? cubesSnapshot[i].touchMask : 0;
 
-        dataAllCubes.addList() = dataCube;
-        dataCube.clear();
+        cubesPose[i] = poseTable.getPose(cubesSnapshot[i].pose);
     }
 }
 
 void iCubeProcessorThread::printDataAlliCubes(){
-    cout<<"print"<<endl;
-    if(dataAllCubes.size() > 0){
-        for(int i = 0; i < dataAllCubes.size(); i++){
-            cout<<"iCube_" <<i<<":  ";
-            cout<<dataAllCubes.get(i).asList()->get(0).asInt32()<<",   [ ";
-            if(dataAllCubes.get(i).asList()->get(1).asList() != NULL)
-                cout<<dataAllCubes.get(i).asList()->get(1).asList()->get(0).asInt32()<<"  "<<dataAllCubes.get(i).asList()->get(1).asList()->get(1).asInt32()<<"  "<<dataAllCubes.get(i).asList()->get(1).asList()->get(2).asInt32()<<"  "<<dataAllCubes.get(i).asList()->get(1).asList()->get(3).asInt32()<<"  "<<dataAllCubes.get(i).asList()->get(1).asList()->get(4).asInt32()<<"  "<<dataAllCubes.get(i).asList()->get(1).asList()->get(5).asInt32();
-            cout<<"],   "<<dataAllCubes.get(i).asList()->get(2).asString()<<endl;
-        }
+    for(int i = 0; i < numberOfICubes; i++){
+        cout<<"iCube_" <<i<<":  status "<<cubesStatus[i]<<",   faces touched "<<countTouchedFaces(cubesTouchMask[i])<<" (mask "<<cubesTouchMask[i]<<"),   "<<cubesPose[i]<<endl;
+        cout<<"    IMU samples: "<<imuFeatures[i].samples<<" shake: "<<imuFeatures[i].shakeEnergy<<" rotation: "<<imuFeatures[i].rotationRate
+            <<" orientationChange: "<<imuFeatures[i].orientationChange<<" freeFall: "<<imuFeatures[i].freeFall<<" thrown: "<<imuFeatures[i].thrown<<endl;
     }
 }
 
+//Message built in place in the port buffer: one list for each cube (status touchMask pose), see iCubeTouch.h
 void iCubeProcessorThread::sendToPerception(){
     if(outputICubeDataPort.getOutputCount()){
-        outputICubeDataPort.prepare() = dataAllCubes;
+        Bottle& dataAllCubes = outputICubeDataPort.prepare();
+        dataAllCubes.clear();
+        for(int i = 0; i < numberOfICubes; i++){
+            Bottle& dataCube = dataAllCubes.addList();
+            dataCube.addInt32(cubesStatus[i]);
+            dataCube.addInt32(cubesTouchMask[i]);
+            dataCube.addString(cubesPose[i]);
+        }
         outputICubeDataPort.write();
     }
 }
 
+void iCubeProcessorThread::sendImuFeatures(){
+    if(outputICubeFeaturesPort.getOutputCount()){
+        Bottle& allFeatures = outputICubeFeaturesPort.prepare();
+        allFeatures.clear();
+        for(int i = 0; i < numberOfICubes; i++){
+            Bottle& features = allFeatures.addList();
+            features.addInt32(imuFeatures[i].samples);
+            features.addFloat64(imuFeatures[i].shakeEnergy);
+            features.addFloat64(imuFeatures[i].rotationRate);
+            features.addFloat64(imuFeatures[i].orientationChange);
+            features.addInt32(imuFeatures[i].freeFall);
+            features.addInt32(imuFeatures[i].thrown);
+        }
+        outputICubeFeaturesPort.write();
+    }
+}
+
 void iCubeProcessorThread::saveHeaders(){
     //Save header in the file
     ofstream fout; 
@@ -244,13 +245,9 @@ void iCubeProcessorThread::save(){
     fout.open(filename, ios::app);
     std::time_t temp = Time::now();
     
-    if(dataAllCubes.size() > 0){
-        for(int i = 0; i < dataAllCubes.size(); i++){
-            fout << timeNow << ',' << to_string(temp - timeInitial) << ',' << i << ',' << dataAllCubes.get(i).asList()->get(0).asInt32()<<",";
-            if(dataAllCubes.get(i).asList()->get(1).asList() != NULL)
-                fout<<dataAllCubes.get(i).asList()->get(1).asList()->get(0).asInt32()<<","<<dataAllCubes.get(i).asList()->get(1).asList()->get(1).asInt32()<<","<<dataAllCubes.get(i).asList()->get(1).asList()->get(2).asInt32()<<","<<dataAllCubes.get(i).asList()->get(1).asList()->get(3).asInt32()<<","<<dataAllCubes.get(i).asList()->get(1).asList()->get(4).asInt32()<<","<<dataAllCubes.get(i).asList()->get(1).asList()->get(5).asInt32();
-            fout<<dataAllCubes.get(i).asList()->get(2).asString()<<'\n';
-        }
+    for(int i = 0; i < numberOfICubes; i++){
+        fout << timeNow << ',' << to_string(temp - timeInitial) << ',' << i << ',' << cubesStatus[i] << ',' << cubesTouchMask[i] << ','
+            << countTouchedFaces(cubesTouchMask[i]) << ',' << cubesPose[i] << '\n';
     }
 
     fout.close();
@@ -274,4 +271,6 @@ void iCubeProcessorThread::threadRelease(){
  
     outputICubeDataPort.interrupt();
     outputICubeDataPort.close();
+    outputICubeFeaturesPort.interrupt();
+    outputICubeFeaturesPort.close();
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file iCubeReader.cpp
+ * @brief Implementation of the iCube reader (see iCubeReader.h).
+ */
+
+#include "iCub/iCubeReader.h"
+
+using namespace yarp::os;
+using namespace std;
+
+int iCubePoseTable::getIndex(const string& pose){
+    lock_guard<mutex> lock(tableMutex);
+    for(int i = 0; i < poses.size(); i++)
+        if(poses[i] == pose)
+            return i;
+    poses.push_back(pose);
+    return poses.size() - 1;
+}
+
+string iCubePoseTable::getPose(int index){
+    lock_guard<mutex> lock(tableMutex);
+    if(index < 0 || index >= poses.size())
+        return "";
+    return poses[index];
+}
+
+iCubeReader::iCubeReader(iCubeSlot* slot_, iCubePoseTable* poseTable_, int readerType_){
+    slot = slot_;
+    poseTable = poseTable_;
+    readerType = readerType_;
+}
+
+void iCubeReader::onRead(Bottle& bottleCube){
+    if(bottleCube.size() == 0)
+        return;
+
+    if(readerType == ICUBE_EVENTS_READER){
+        int pose = poseTable->getIndex(bottleCube.get(0).asString());
+        lock_guard<mutex> lock(slot->stateMutex);
+        slot->state.pose = pose;
+        return;
+    }
+
+    //data: quaternion (0-3), touch of each face as "0"/"1" (4-9), acceleration (10-12)
+    unsigned int touchMask = 0;
+    for(int i = 0; i < NUMBER_OF_FACES; i++){
+        Value& face = bottleCube.get(4 + i);
+        bool touched = face.isString() ? face.asString().find("1") != string::npos : face.asInt32() != 0;
+        touchMask |= (unsigned int)touched << i;
+    }
+
+    lock_guard<mutex> lock(slot->stateMutex);
+    for(int i = 0; i < 4; i++)
+        slot->state.quaternion[i] = bottleCube.get(i).asFloat64();
+    for(int i = 0; i < 3; i++)
+        slot->state.acceleration[i] = bottleCube.get(10 + i).asFloat64();
+    slot->state.touchMask = touchMask;
+    slot->state.newData = true;
+
+    pushImuSample(slot->imu, slot->state.quaternion, slot->state.acceleration, Time::now());
+}
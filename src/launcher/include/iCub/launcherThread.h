@@ -0,0 +1,120 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file launcherThread.h
+ * @brief Starts the modules of the topology at the same time and connects their ports as soon as both ends exist.
+ */
+
+#ifndef _LAUNCHER_PERIODTHREAD_H_
+#define _LAUNCHER_PERIODTHREAD_H_
+
+#include <yarp/os/all.h>
+#include <yarp/os/PeriodicThread.h>
+#include <yarp/os/Log.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+
+#define LAUNCHER_PERIOD             0.1     //s between two rounds of connections
+#define LAUNCHER_PROBE_PERIOD       1.0     //s between two readiness probes of the modules
+#define LAUNCHER_PROBE_TIMEOUT      0.5     //s to wait for the answer of a module
+#define LAUNCHER_RECHECK_PERIOD     2.0     //s between two checks of the connections already done (a module restarted)
+#define LAUNCHER_REPORT_PERIOD      5.0     //s between two reports of what is missing
+#define LAUNCHER_STOP_TIMEOUT       10.0    //s to wait for the modules to quit before killing them
+
+#define NO_PROCESS      -1
+
+//A module of the topology: the binary, its parameters (same as the XML) and the RPC port of its RFModule
+typedef struct launchedModule_{
+    std::string name;
+    std::string parameters;
+    std::string rpcPort;
+    pid_t pid;
+    bool ready;
+    double timeReady;
+}launchedModule;
+
+typedef struct topologyConnection_{
+    std::string from;
+    std::string to;
+    std::string protocol;
+    bool connected;
+}topologyConnection;
+
+class launcherThread : public yarp::os::PeriodicThread {
+private:
+    std::string name;
+    yarp::os::ResourceFinder rf;
+    bool stopModules;                           //the modules started are stopped when the launcher quits
+
+    std::mutex stateMutex;                      //modules and connections are also read by the RPC of the module
+    std::vector<launchedModule> modules;
+    std::vector<topologyConnection> connections;
+
+    std::vector<std::unique_ptr<yarp::os::RpcClient>> probePorts;  //asks "ready" to each module, one for each module (connected once)
+
+    double timeStart;
+    double timeAllReady;                        //-1 until all the modules answer ready
+    double timeFirstDecision;                   //-1 until decision making sends the first behavior
+    double lastRecheck;
+    double lastProbe;
+    double lastReport;
+
+    bool loadTopology();
+    std::string rpcPortOf(const std::string& moduleName, const std::string& parameters);
+    bool startModule(launchedModule& module);
+    void stopAllModules();
+    void closeProbePorts();
+
+    void connectPorts();
+    void probeModules();
+    void checkExits();
+    void report();
+    bool allReady();
+
+    bool probe(int module, const std::string& command, yarp::os::Bottle& reply);
+
+public:
+    launcherThread(yarp::os::ResourceFinder &_rf, bool _stopModules);
+    ~launcherThread();
+
+    bool threadInit();
+    void threadRelease();
+    void run();
+
+    void setName(std::string str);
+    std::string getName(const char* p);
+
+    /**
+    * true when all the modules answered ready
+    */
+    bool isReady();
+
+    /**
+    * one line for each module (name ready/wait) and the connections missing
+    */
+    yarp::os::Bottle getStatus();
+};
+
+#endif  //_LAUNCHER_PERIODTHREAD_H_
+
+//----- end-of-file --- ( next line intentionally left blank ) ------------------
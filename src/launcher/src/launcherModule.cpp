@@ -0,0 +1,119 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file launcherModule.cpp
+ * @brief Implementation of the launcherModule (see header file).
+ */
+
+#include "iCub/launcherModule.h"
+
+using namespace yarp::os;
+using namespace std;
+
+bool launcherModule::configure(yarp::os::ResourceFinder &rf) {
+    if(rf.check("help")){
+        printf("HELP \n");
+        printf("====== \n");
+        printf("--from           : topology with the [modules] and [connections] of the application (default topology.ini) \n");
+        printf("--context        : motivatedAutonomousAgent or motivatedAutonomousAgent_SIM \n");
+        printf("--stopModules    : 1 (default) to stop the modules started when the launcher quits \n");
+        printf(" \n");
+        printf("press CTRL-C to stop... \n");
+        return true;
+    }
+
+    /* get the module name which will form the stem of all module port names */
+    moduleName            = rf.check("name",
+                           Value("/launcher"), 
+                           "module name (string)").asString();
+    setName(moduleName.c_str());
+
+    handlerPortName =  "";
+    handlerPortName += getName();         // use getName() rather than a literal 
+
+    if (!handlerPort.open(handlerPortName.c_str())) {           
+        cout << getName() << ": Unable to open port " << handlerPortName << endl;  
+        return false;
+    }
+
+    attach(handlerPort);                  // attach to port
+
+    bool stopModules = rf.check("stopModules", Value(1), "stop the modules when quitting (int)").asInt32() != 0;
+
+    /* create the thread and pass pointers to the module parameters */
+    pThread = new launcherThread(rf, stopModules);
+    pThread->setName(getName().c_str());
+    
+    /* now start the thread to do the work */
+    return pThread->start(); // this calls threadInit() and it if returns true, it then calls run()
+}
+
+bool launcherModule::interruptModule() {
+    handlerPort.interrupt();
+    return true;
+}
+
+bool launcherModule::close() {
+    handlerPort.close();
+    /* stop the thread */
+    yDebug("stopping the thread \n");
+    if (pThread != nullptr)
+        pThread->stop();
+    return true;
+}
+
+bool launcherModule::respond(const Bottle& command, Bottle& reply) 
+{
+    string helpMessage =  string(getName().c_str()) + 
+                " commands are: \n" +  
+                "help \n" +
+                "ready : ok when all the modules are ready, wait before \n" +
+                "status : (module ready/wait/exited timeReady) for each module and (missing from to) for each connection not done \n" +
+                "quit \n";
+    reply.clear(); 
+
+    if (command.get(0).asString()=="quit") {
+        reply.addString("quitting");
+        return false;     
+    }
+    else if (command.get(0).asString()=="help") {
+        cout << helpMessage;
+        reply.addString("ok");
+    }
+    else if (command.get(0).asString()=="ready") {
+        reply.addString(pThread != nullptr && pThread->isReady() ? "ok" : "wait");
+    }
+    else if (command.get(0).asString()=="status") {
+        if (pThread != nullptr)
+            reply = pThread->getStatus();
+    }
+    
+    return true;
+}
+
+/* Called periodically every getPeriod() seconds */
+bool launcherModule::updateModule()
+{
+    return true;
+}
+
+double launcherModule::getPeriod()
+{
+    /* module periodicity (seconds), called implicitly by myModule */
+    return 1;
+}
@@ -0,0 +1,363 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file launcherThread.cpp
+ * @brief Implementation of the launcher thread (see launcherThread.h).
+ */
+
+#include "iCub/launcherThread.h"
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+using namespace yarp::os;
+using namespace std;
+
+launcherThread::launcherThread(ResourceFinder &_rf, bool _stopModules):PeriodicThread(LAUNCHER_PERIOD){
+    rf = _rf;
+    stopModules = _stopModules;
+    timeStart = 0;
+    timeAllReady = -1;
+    timeFirstDecision = -1;
+    lastRecheck = 0;
+    lastProbe = 0;
+    lastReport = 0;
+}
+
+launcherThread::~launcherThread() {
+    // do nothing
+}
+
+void launcherThread::setName(string str) {
+    this->name=str;
+}
+
+std::string launcherThread::getName(const char* p) {
+    string str(name);
+    str.append(p);
+    return str;
+}
+
+//[modules]: binary "parameters"          [connections]: /to/port (/from/port protocol)
+//an input port is written by only one output, so it is the key of the connection
+bool launcherThread::loadTopology(){
+    Bottle& modulesGroup = rf.findGroup("modules");
+    if(modulesGroup.size() < 2){
+        yError("the topology has no [modules]");
+        return false;
+    }
+    for(int i = 1; i < modulesGroup.size(); i++){
+        Bottle* line = modulesGroup.get(i).asList();
+        if(line == nullptr || line->size() < 1)
+            continue;
+        launchedModule module;
+        module.name = line->get(0).asString();
+        module.parameters = line->size() > 1 ? line->get(1).asString() : "";
+        module.rpcPort = rpcPortOf(module.name, module.parameters);
+        module.pid = NO_PROCESS;
+        module.ready = false;
+        module.timeReady = -1;
+        modules.push_back(module);
+    }
+
+    Bottle& connectionsGroup = rf.findGroup("connections");
+    for(int i = 1; i < connectionsGroup.size(); i++){
+        Bottle* line = connectionsGroup.get(i).asList();
+        Bottle* source = line != nullptr && line->size() == 2 ? line->get(1).asList() : nullptr;
+        if(source == nullptr || source->size() < 1){
+            yError("Each connection must be /to/port (/from/port protocol): %s", line != nullptr ? line->toString().c_str() : "");
+            return false;
+        }
+        topologyConnection connection;
+        connection.to = line->get(0).asString();
+        connection.from = source->get(0).asString();
+        connection.protocol = source->size() > 1 ? source->get(1).asString() : "";
+        connection.connected = false;
+        connections.push_back(connection);
+    }
+
+    yInfo("Topology: %d modules, %d connections", (int)modules.size(), (int)connections.size());
+    return true;
+}
+
+//the handler port of the RFModule is its name, /binary if --name is not given
+string launcherThread::rpcPortOf(const string& moduleName, const string& parameters){
+    Bottle tokens(parameters);
+    string port = moduleName;
+    for(int i = 0; i + 1 < tokens.size(); i++)
+        if(tokens.get(i).asString() == "--name")
+            port = tokens.get(i + 1).asString();
+    return port[0] == '/' ? port : "/" + port;
+}
+
+bool launcherThread::startModule(launchedModule& module){
+    //the arguments are prepared before the fork, the child only calls exec
+    Bottle tokens(module.parameters);
+    vector<string> arguments;
+    arguments.push_back(module.name);
+    for(int i = 0; i < tokens.size(); i++)
+        arguments.push_back(tokens.get(i).isString() ? tokens.get(i).asString() : tokens.get(i).toString());
+
+    vector<char*> argv;
+    for(int i = 0; i < arguments.size(); i++)
+        argv.push_back(const_cast<char*>(arguments[i].c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if(pid < 0){
+        yError("unable to start %s", module.name.c_str());
+        return false;
+    }
+    if(pid == 0){
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    module.pid = pid;
+    yInfo("Started %s %s (pid %d)", module.name.c_str(), module.parameters.c_str(), (int)pid);
+    return true;
+}
+
+bool launcherThread::threadInit() {
+    if(!loadTopology())
+        return false;
+
+    for(int i = 0; i < modules.size(); i++){
+        probePorts.push_back(unique_ptr<RpcClient>(new RpcClient()));
+        if(!probePorts[i]->open(getName(("/probe" + modules[i].rpcPort + ":rpc").c_str()).c_str())){
+            yError("unable to open port to probe %s", modules[i].name.c_str());
+            closeProbePorts();
+            return false;
+        }
+        probePorts[i]->asPort().setTimeout(LAUNCHER_PROBE_TIMEOUT);
+    }
+
+    //all at the same time, each one waits for its own connections (connectionBarrier) while the others start
+    timeStart = Time::now();
+    for(int i = 0; i < modules.size(); i++)
+        if(!startModule(modules[i])){
+            stopAllModules();
+            closeProbePorts();
+            return false;
+        }
+
+    return true;
+}
+
+void launcherThread::run() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        connectPorts();
+    }
+    //only this thread changes the modules, the lock is taken to write the answers and not during the RPC
+    probeModules();
+    {
+        lock_guard<mutex> lock(stateMutex);
+        checkExits();
+        report();
+    }
+}
+
+void launcherThread::connectPorts(){
+    double now = Time::now();
+    bool recheck = now - lastRecheck >= LAUNCHER_RECHECK_PERIOD;
+    if(recheck)
+        lastRecheck = now;
+
+    //a port is asked to the name server once per round
+    map<string, bool> exists;
+    auto portExists = [&exists](const string& port){
+        if(exists.find(port) == exists.end())
+            exists[port] = Network::exists(port, true);
+        return exists[port];
+    };
+
+    for(int i = 0; i < connections.size(); i++){
+        topologyConnection& connection = connections[i];
+        if(connection.connected){
+            //a module that restarted lost its connections
+            if(recheck && !Network::isConnected(connection.from, connection.to, true)){
+                yWarning("Connection lost %s -> %s", connection.from.c_str(), connection.to.c_str());
+                connection.connected = false;
+            }
+            continue;
+        }
+        if(!portExists(connection.from) || !portExists(connection.to))
+            continue;
+
+        connection.connected = Network::isConnected(connection.from, connection.to, true) ||
+                               Network::connect(connection.from, connection.to, connection.protocol, true);
+        if(connection.connected)
+            yInfo("Connected %s -> %s after %.2f s", connection.from.c_str(), connection.to.c_str(), now - timeStart);
+    }
+}
+
+//the connection is kept between the probes, it is done again if the module restarted
+bool launcherThread::probe(int module, const string& command, Bottle& reply){
+    RpcClient& port = *probePorts[module];
+    const string& rpcPort = modules[module].rpcPort;
+    if(port.getOutputCount() == 0 && (!Network::exists(rpcPort, true) || !Network::connect(port.getName(), rpcPort, "", true)))
+        return false;
+
+    Bottle request;
+    request.addString(command);
+    reply.clear();
+    return port.write(request, reply);
+}
+
+void launcherThread::probeModules(){
+    double now = Time::now();
+    if(now - lastProbe < LAUNCHER_PROBE_PERIOD)
+        return;
+    lastProbe = now;
+    Bottle reply;
+
+    for(int i = 0; i < modules.size(); i++){
+        if(modules[i].ready || modules[i].pid == NO_PROCESS)
+            continue;
+        if(probe(i, "ready", reply) && reply.get(0).asString() == "ok"){
+            lock_guard<mutex> lock(stateMutex);
+            modules[i].ready = true;
+            modules[i].timeReady = Time::now() - timeStart;
+            yInfo("%s ready after %.2f s", modules[i].name.c_str(), modules[i].timeReady);
+        }
+    }
+
+    if(timeAllReady < 0 && allReady()){
+        timeAllReady = Time::now() - timeStart;
+        yInfo("All the modules ready after %.2f s", timeAllReady);
+    }
+
+    //cold start: from the launch to the first behavior sent by decision making
+    if(timeAllReady >= 0 && timeFirstDecision < 0){
+        for(int i = 0; i < modules.size(); i++)
+            if(modules[i].name == "decisionMaking" && probe(i, "firstDecision", reply) && reply.get(0).asFloat64() > 0){
+                timeFirstDecision = reply.get(0).asFloat64() - timeStart;
+                yInfo("First decision %.2f s after the launch", timeFirstDecision);
+            }
+    }
+}
+
+void launcherThread::checkExits(){
+    for(int i = 0; i < modules.size(); i++){
+        int status;
+        if(modules[i].pid != NO_PROCESS && waitpid(modules[i].pid, &status, WNOHANG) == modules[i].pid){
+            yError("%s exited (status %d)", modules[i].name.c_str(), WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+            modules[i].pid = NO_PROCESS;
+            modules[i].ready = false;
+        }
+    }
+}
+
+void launcherThread::report(){
+    double now = Time::now();
+    if(now - lastReport < LAUNCHER_REPORT_PERIOD)
+        return;
+    lastReport = now;
+
+    string waiting;
+    for(int i = 0; i < modules.size(); i++)
+        if(!modules[i].ready && modules[i].pid != NO_PROCESS)
+            waiting += " " + modules[i].name;
+    if(!waiting.empty())
+        yInfo("Modules not ready yet:%s", waiting.c_str());
+
+    int missing = 0;
+    for(int i = 0; i < connections.size(); i++)
+        if(!connections[i].connected){
+            if(missing == 0)
+                yInfo("Connections missing:");
+            yInfo("    %s -> %s", connections[i].from.c_str(), connections[i].to.c_str());
+            missing++;
+        }
+}
+
+bool launcherThread::allReady(){
+    for(int i = 0; i < modules.size(); i++)
+        if(!modules[i].ready)
+            return false;
+    return !modules.empty();
+}
+
+bool launcherThread::isReady(){
+    lock_guard<mutex> lock(stateMutex);
+    return allReady();
+}
+
+Bottle launcherThread::getStatus(){
+    lock_guard<mutex> lock(stateMutex);
+    Bottle status;
+    for(int i = 0; i < modules.size(); i++){
+        Bottle& module = status.addList();
+        module.addString(modules[i].name);
+        module.addString(modules[i].ready ? "ready" : (modules[i].pid == NO_PROCESS ? "exited" : "wait"));
+        module.addFloat64(modules[i].timeReady);
+    }
+    for(int i = 0; i < connections.size(); i++)
+        if(!connections[i].connected){
+            Bottle& connection = status.addList();
+            connection.addString("missing");
+            connection.addString(connections[i].from);
+            connection.addString(connections[i].to);
+        }
+    return status;
+}
+
+void launcherThread::stopAllModules(){
+    for(int i = 0; i < modules.size(); i++)
+        if(modules[i].pid != NO_PROCESS)
+            kill(modules[i].pid, SIGTERM);
+
+    double start = Time::now();
+    bool running = true;
+    while(running && Time::now() - start < LAUNCHER_STOP_TIMEOUT){
+        running = false;
+        for(int i = 0; i < modules.size(); i++){
+            int status;
+            if(modules[i].pid != NO_PROCESS && waitpid(modules[i].pid, &status, WNOHANG) == 0)
+                running = true;
+            else
+                modules[i].pid = NO_PROCESS;
+        }
+        if(running)
+            Time::delay(LAUNCHER_PERIOD);
+    }
+
+    for(int i = 0; i < modules.size(); i++)
+        if(modules[i].pid != NO_PROCESS){
+            yWarning("%s did not quit, killing it", modules[i].name.c_str());
+            kill(modules[i].pid, SIGKILL);
+            waitpid(modules[i].pid, nullptr, 0);
+            modules[i].pid = NO_PROCESS;
+        }
+}
+
+void launcherThread::closeProbePorts(){
+    for(int i = 0; i < probePorts.size(); i++){
+        probePorts[i]->interrupt();
+        probePorts[i]->close();
+    }
+    probePorts.clear();
+}
+
+void launcherThread::threadRelease(){
+    if(stopModules)
+        stopAllModules();
+
+    closeProbePorts();
+}
@@ -0,0 +1,86 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file driveEngine.h
+ * @brief Table of the needs of the robot and their drives, updated together at each step.
+ */
+
+#ifndef _DRIVEENGINE_H_
+#define _DRIVEENGINE_H_
+
+#include <string>
+#include <vector>
+
+//sign of the drive: positive when the drive is negative for a need below the homeostasis (battery, comfort),
+//negative when the drive is negative for a need above the homeostasis (boredom)
+#define DRIVE_SIGN_DIRECT     1.0
+#define DRIVE_SIGN_INVERSE   -1.0
+
+#define NO_NEED -1
+
+/*  Table of needs stored as structure-of-arrays: each need is one index in all the vectors.
+    All the drives are updated in one pass per tick (no branches inside the loops, so the compiler can vectorize them).
+    drive = sign * (min(value - lowerBound, 0) + max(value - upperBound, 0)), that is 0 inside [H - range, H + range]
+*/
+class driveEngine{
+    private:
+        std::vector<std::string> names;
+        std::vector<double> value;          //current value of the need
+        std::vector<double> minValue;
+        std::vector<double> maxValue;
+        std::vector<double> homeostasis;    //absolute homeostasis threshold (H)
+        std::vector<double> range;          //the need is satisfied in [H - range, H + range]
+        std::vector<double> sign;           //DRIVE_SIGN_DIRECT or DRIVE_SIGN_INVERSE
+        std::vector<double> gain;           //increase of the need for each unit of stimulus
+        std::vector<double> decay;          //decrease of the need at each tick
+        std::vector<double> stimulus;       //stimulus accumulated since the last tick
+        std::vector<double> enabled;        //1 if the drive is used, 0 otherwise (drive always 0, it is considered satisfied)
+        std::vector<double> drive;
+
+    public:
+        driveEngine();
+        ~driveEngine();
+
+        /**
+        * add a need to the table
+        * @param homeostasis_ absolute homeostasis threshold (not the percentage)
+        * @return index of the need
+        */
+        int addNeed(std::string name, double initValue, double min, double max, double homeostasis_, double range_, double sign_, double gain_, double decay_, bool enabled_);
+
+        int getIndex(std::string name);
+        int size();
+        std::string getName(int index);
+
+        void setValue(int index, double newValue);
+        double getValue(int index);
+        double getDrive(int index);
+        double getHomeostasis(int index);
+        double getRange(int index);
+        bool isEnabled(int index);
+
+        void addStimulus(int index, double newStimulus);
+
+        /**
+        * integrate stimuli and decay of all the needs and recompute all the drives
+        */
+        void update();
+        void computeDrives();
+};
+
+#endif  //_DRIVEENGINE_H_
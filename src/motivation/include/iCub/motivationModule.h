@@ -49,7 +49,7 @@ class motivationModule:public yarp::os::RFModule {
     
     yarp::os::Port handlerPort;              // a port to handle messages 
     /*  */
-    motivationThread *pThread;             // pointer to a new thread to be created and started in configure() and stopped in close()
+    motivationThread *pThread = nullptr; // pointer to a new thread to be created and started in configure() and stopped in close()
 
     std::string robot_color;
     std::string robot_profile;
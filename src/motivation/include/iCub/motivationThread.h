@@ -39,6 +39,14 @@
 #include <random>
 #include <algorithm>
 #include <string.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+
+#include "iCub/driveEngine.h"
+#include "iCub/iCubeTouch.h"
+#include "iCub/connectionBarrier.h"
+#include "iCub/monitoredThread.h"
 
 //Used when the robot's eyes are closed
 #define NOFACE -1.0 //Must tbe same value in perception
@@ -50,11 +58,21 @@
 #define RULE_BASED          "rulebased"
 #define DRIVE_BASED        "drivebased"
 
+//Layout of the drive-state message (/motivation/driveState:o). Must be the same values in decisionMaking
+#define STATE_EXPLORE_DRIVE     0
+#define STATE_SURVIVE_DRIVE     1
+#define STATE_AFFECT_DRIVE      2
+#define STATE_BOREDOM           3
+#define STATE_COMFORT           4
+#define STATE_BATTERY           5
+#define STATE_OBJECT_COLOR      6
+#define STATE_EXTRA_DRIVES      7   //then one drive for each name in EXTRA_DRIVES (same order)
+
 #define SOCIAL_PROFILE  "social"
 #define PLAYFUL_PROFILE "playful"
 #define REGULAR_PROFILE "regular"
 
-class motivationThread : public yarp::os::PeriodicThread {
+class motivationThread : public monitoredThread {
 private:
 
     std::string robot;              // name of the robot
@@ -76,12 +94,16 @@ private:
     std::string filenameAllObjectsMemory = "motivation_AllObjectsMemory.csv";
     std::string fileHeaderAllObjectsMemory = "time,durationExp,objectColor,value,seeing";
 
+    //Binary snapshot of the objects memory, restored at startup to have a warm start between sessions
+    std::string filenameObjectsSnapshot = "motivation_ObjectsMemory.bin";
+
     std::mt19937 rdx{static_cast<long unsigned int>(21)};
 
     typedef struct objects_{
         std::string color;
         double value;
         bool seeing;
+        double lastSeen;    //wall clock time (s) of the last time the object was in the FOV
     }objects;
 
     std::vector<objects> allObjectsMemory;
@@ -103,6 +125,13 @@ private:
     double affectDrive;
     bool computeDrives = true;
 
+    //Table with all the needs/drives (the built-in ones and the ones declared in EXTRA_DRIVES)
+    driveEngine drives;
+    int needComfort;
+    int needBattery;
+    int needBoredom;
+    std::vector<int> extraNeeds;
+
     //defined as class variable just to save data easier;
     double batteryLevel;
     int numberOfObjectsScene;
@@ -146,6 +175,14 @@ private:
     int RANGE_AFFECT;
     int RANGE_SURVIVE;
 
+    //Names of the drives that are computed just by the drive engine: parameters in DRIVE_<name> (min, max, init, homeostasis, range, sign, gain, decay)
+    yarp::os::Bottle EXTRA_DRIVES;
+
+    //1 if the objects memory is saved/restored between sessions, 0 otherwise
+    int PERSIST_OBJECTS_MEMORY;
+    //Time (s) for the interest already spent in an object to decay to half while the robot is off
+    double OBJECTS_MEMORY_HALFLIFE;
+
     std::string mode;          //LEARNING_PHASE, TESTING_PHASE, FINETUNING_PHASE, RULE_BASED
 
     //-------------------------End of the Values defined in the configuration file
@@ -159,18 +196,17 @@ private:
 
     yarp::os::BufferedPort<yarp::os::Bottle> inputPortEndInitialBehavior;
 
-    yarp::os::BufferedPort<yarp::os::Bottle> outputExploreDriveAndObject;     //write the explore drive + most interesting object to interact
-    yarp::os::BufferedPort<yarp::os::Bottle> outputSurvivalDrivePort;           //write the survival drive (battery)
-    yarp::os::BufferedPort<yarp::os::Bottle> outputAffectDrivePort;             //write the affect drive according to the comfort value
-
-    //Ports used to debug the behavior of the needs (Boredom, Comfort)
-    yarp::os::BufferedPort<yarp::os::Bottle> outputComfortPort;
-    yarp::os::BufferedPort<yarp::os::Bottle> outputBoredomPort;
+    //write all the drives, the needs and the most interesting object to interact in one message (layout in STATE_*)
+    //the envelope has the sequence number and the time of the step
+    yarp::os::BufferedPort<yarp::os::Bottle> outputDriveStatePort;
+    yarp::os::Stamp driveStateStamp;
 
     yarp::os::BufferedPort<yarp::os::Bottle> inputPortSaturetedAffect;
 
     yarp::os::BufferedPort<yarp::os::Bottle> inputiCubesPort;
 
+    yarp::os::BufferedPort<yarp::os::Bottle> inputNeedsStimuliPort;            //read stimuli for the extra drives: name value [name value ...]
+
 public:
     /**
     * constructor default
@@ -208,7 +244,7 @@ public:
     /**
     *  active part of the thread
     */
-    void run(); 
+    void tick() override;
 
     /**
     * function that sets the rootname of all the ports that are going to be created by the thread
@@ -243,6 +279,9 @@ public:
     void saveHeaders();
     void saveObjectsMemory();
 
+    bool loadObjectsSnapshot();
+    bool saveObjectsSnapshot();
+
     void updateObjectMemory();
     
     void computeInterestInObjects();
@@ -254,9 +293,11 @@ public:
     void computeBoredom();
     void startDrivesComputation();
 
-    float comfortProcessing();
+    void initDrivesTable();
+    void readNeedsStimuli();
+    void updateDrives();
 
-    float computeDrive(float need, int homeostasis_base, int range);
+    float comfortProcessing();
 
     void resetVars();
 
@@ -0,0 +1,120 @@
+// -*- mode:C++; tab-width:4; c-basic-offset:4; indent-tabs-mode:nil -*-
+
+/*
+    * Copyright: (C) 2022 Istituto Italiano di Tecnologia | Robotics, Brains and Cognitive Science
+    * Permission is granted to copy, distribute, and/or modify this program
+    * under the terms of the GNU General Public License, version 2 or any
+    * later version published by the Free Software Foundation.
+    *
+    * A copy of the license can be found at
+    * http://www.robotcub.org/icub/license/gpl.txt
+    *
+    * This program is distributed in the hope that it will be useful, but
+    * WITHOUT ANY WARRANTY; without even the implied warranty of
+    * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+    * Public License for more details
+*/
+
+/**
+ * @file driveEngine.cpp
+ * @brief Implementation of the drive engine (see driveEngine.h).
+ */
+
+#include "iCub/driveEngine.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+driveEngine::driveEngine(){
+}
+
+driveEngine::~driveEngine(){
+}
+
+int driveEngine::addNeed(string name, double initValue, double min, double max, double homeostasis_, double range_, double sign_, double gain_, double decay_, bool enabled_){
+    names.push_back(name);
+    value.push_back(initValue);
+    minValue.push_back(min);
+    maxValue.push_back(max);
+    homeostasis.push_back(homeostasis_);
+    range.push_back(range_);
+    sign.push_back(sign_);
+    gain.push_back(gain_);
+    decay.push_back(decay_);
+    stimulus.push_back(0.0);
+    enabled.push_back(enabled_ ? 1.0 : 0.0);
+    drive.push_back(0.0);
+
+    return names.size() - 1;
+}
+
+int driveEngine::getIndex(string name){
+    for(int i = 0; i < names.size(); i++)
+        if(names[i].compare(name) == 0)
+            return i;
+    return NO_NEED;
+}
+
+int driveEngine::size(){
+    return names.size();
+}
+
+string driveEngine::getName(int index){
+    return names[index];
+}
+
+void driveEngine::setValue(int index, double newValue){
+    value[index] = newValue;
+}
+
+double driveEngine::getValue(int index){
+    return value[index];
+}
+
+double driveEngine::getDrive(int index){
+    return drive[index];
+}
+
+double driveEngine::getHomeostasis(int index){
+    return homeostasis[index];
+}
+
+double driveEngine::getRange(int index){
+    return range[index];
+}
+
+bool driveEngine::isEnabled(int index){
+    return enabled[index] != 0.0;
+}
+
+void driveEngine::addStimulus(int index, double newStimulus){
+    stimulus[index] += newStimulus;
+}
+
+void driveEngine::update(){
+    const int n = names.size();
+    double *v = value.data();
+    const double *lo = minValue.data(), *hi = maxValue.data(), *g = gain.data(), *d = decay.data();
+    double *s = stimulus.data();
+
+    //needs dynamics: stimulus increases the need, decay decreases it, always kept in [min, max]
+    for(int i = 0; i < n; i++){
+        v[i] = min(max(v[i] + g[i] * s[i] - d[i], lo[i]), hi[i]);
+        s[i] = 0.0;
+    }
+
+    computeDrives();
+}
+
+void driveEngine::computeDrives(){
+    const int n = names.size();
+    const double *v = value.data(), *h = homeostasis.data(), *r = range.data(), *sg = sign.data(), *e = enabled.data();
+    double *dr = drive.data();
+
+    for(int i = 0; i < n; i++){
+        double distance = min(v[i] - (h[i] - r[i]), 0.0) + max(v[i] - (h[i] + r[i]), 0.0);//0 in homeostasis, distance to the closest bound otherwise
+        dr[i] = e[i] * sg[i] * distance + 0.0;//+ 0.0 to not send -0
+    }
+}
@@ -33,16 +33,19 @@ using namespace boost;
 #define THPERIOD 0.5 //s
 #define NON_EXIST -1 //Must be the same value defined in objectPerception module
 
-motivationThread::motivationThread():PeriodicThread(THPERIOD) {
+#define SNAPSHOT_MAGIC      0x4D4F424A //"MOBJ"
+#define SNAPSHOT_VERSION    1
+
+motivationThread::motivationThread():monitoredThread(THPERIOD) {
     robot = "icub";        
 }
 
-motivationThread::motivationThread(string _robot, string _configFile):PeriodicThread(THPERIOD){
+motivationThread::motivationThread(string _robot, string _configFile):monitoredThread(THPERIOD){
     robot = _robot;
     configFile = _configFile;
 }
 
-motivationThread::motivationThread(string _robot, ResourceFinder &_rf, string _robot_color, string _robot_profile):PeriodicThread(THPERIOD){
+motivationThread::motivationThread(string _robot, ResourceFinder &_rf, string _robot_color, string _robot_profile):monitoredThread(THPERIOD){
     robot = _robot;
     rf = _rf;
     robot_color = _robot_color;
@@ -99,18 +102,8 @@ bool motivationThread::openAllPorts(){
         return false;  // unable to open; let RFModule know so that it won't run
     }
 
-    if(!outputAffectDrivePort.open(getName("/affectDrive:o").c_str())){
-        yError("unable to open port to receive input");
-        return false;  // unable to open; let RFModule know so that it won't run
-    }
-    
-    if(!outputExploreDriveAndObject.open(getName("/exploreDriveObject:o").c_str())){
-        yError("unable to open port to receive output");
-        return false;  // unable to open; let RFModule know so that it won't run
-    }
-        
-    if(!outputSurvivalDrivePort.open(getName("/survivalDrive:o").c_str())){
-        yError("unable to open port to receive output");
+    if(!outputDriveStatePort.open(getName("/driveState:o").c_str())){
+        yError("unable to open port to send output");
         return false;  // unable to open; let RFModule know so that it won't run
     }
 
@@ -124,14 +117,8 @@ bool motivationThread::openAllPorts(){
         return false;  // unable to open; let RFModule know so that it won't run
     }
 
-    //######### Just for debugging #########
-    if(!outputBoredomPort.open(getName("/boredom:o").c_str())){
-        yError("unable to open port to receive output");
-        return false;  // unable to open; let RFModule know so that it won't run
-    }
-
-    if(!outputComfortPort.open(getName("/comfort:o").c_str())){
-        yError("unable to open port to receive output");
+    if(!inputNeedsStimuliPort.open(getName("/needsStimuli:i").c_str())){
+        yError("unable to open port to receive input");
         return false;  // unable to open; let RFModule know so that it won't run
     }
 
@@ -141,16 +128,16 @@ bool motivationThread::openAllPorts(){
 bool motivationThread::waitForPortConnections(){
     yInfo("Wait for iCub port connections");
 
-    while(inputBatteryLevelPort.getInputCount() < 1);
-    while(inputAllObjects.getInputCount() < 1);
-    while(inputUpdateBoredomPort.getInputCount() < 1);
-    while(inputInteractionPort.getInputCount() < 1);
-    while(outputExploreDriveAndObject.getOutputCount() < 1);
-    while(outputSurvivalDrivePort.getOutputCount() < 1);
-    while(outputAffectDrivePort.getOutputCount() < 1);
-    while(inputPortResetBoredomComfort.getInputCount() < 1);
+    connectionBarrier connections;
+    connections.configure(rf.findGroup("variables"));
+    connections.addInput(inputBatteryLevelPort);
+    connections.addInput(inputAllObjects);
+    connections.addInput(inputUpdateBoredomPort);
+    connections.addInput(inputInteractionPort);
+    connections.addOutput(outputDriveStatePort);
+    connections.addInput(inputPortResetBoredomComfort);
 
-    return true;
+    return connections.wait();
 }
 
 void motivationThread::initAllVars(){
@@ -183,9 +170,41 @@ void motivationThread::initAllVars(){
 
     resetVars();
 
-    affectDrive = computeDrive(comfort_current, AFFECT_HOMEOSTASIS, RANGE_AFFECT);
-    surviveDrive = computeDrive(batteryLevel, SURVIVAL_HOMEOSTASIS, RANGE_SURVIVE);
-    exploreDrive = computeDrive(boredom, EXPLORE_HOMEOSTASIS, RANGE_EXPLORE) * (-1);
+    initDrivesTable();
+    updateDrives();
+}
+
+//The built-in needs have their own dynamics (computeAffect, computeEnergy, computeBoredom), so no gain/decay in the engine
+//Their homeostasis is truncated to int as in the former computeDrive (e.g. boredom 39.99999 -> 39), to keep the same bounds
+void motivationThread::initDrivesTable(){
+    needComfort = drives.addNeed("comfort", comfort_current, MIN_COMFORT, MAX_COMFORT, (int)AFFECT_HOMEOSTASIS, RANGE_AFFECT, DRIVE_SIGN_DIRECT, 0.0, 0.0, DRIVE_AFFECT);
+    needBattery = drives.addNeed("battery", batteryLevel, MIN_BATTERY, MAX_BATTERY, (int)SURVIVAL_HOMEOSTASIS, RANGE_SURVIVE, DRIVE_SIGN_DIRECT, 0.0, 0.0, DRIVE_SURVIVE);
+    needBoredom = drives.addNeed("boredom", boredom, MIN_BOREDOM, MAX_BOREDOM, (int)EXPLORE_HOMEOSTASIS, RANGE_EXPLORE, DRIVE_SIGN_INVERSE, 0.0, 0.0, DRIVE_BOREDOM);
+
+    for(int i = 0; i < EXTRA_DRIVES.size(); i++){
+        string driveName = EXTRA_DRIVES.get(i).asString();
+        Bottle* params = rf.findGroup("variables").find("DRIVE_" + driveName).asList();
+        if(params == nullptr || drives.getIndex(driveName) != NO_NEED){
+            yWarning("ignoring the drive %s: DRIVE_%s is not defined or the name is already used", driveName.c_str(), driveName.c_str());
+            continue;
+        }
+
+        double minNeed = params->check("min", Value(0.0)).asFloat64();
+        double maxNeed = params->check("max", Value(100.0)).asFloat64();
+        double initNeed = params->check("init", Value(maxNeed)).asFloat64();
+        double percenHomeostasis = params->check("homeostasis", Value(0.5)).asFloat64();
+        double rangeNeed = params->check("range", Value(5.0)).asFloat64();
+        double signDrive = params->check("sign", Value(DRIVE_SIGN_DIRECT)).asFloat64() < 0 ? DRIVE_SIGN_INVERSE : DRIVE_SIGN_DIRECT;
+        double gainNeed = params->check("gain", Value(1.0)).asFloat64();
+        double decayNeed = params->check("decay", Value(0.0)).asFloat64();
+
+        //same convention of the built-in needs: the percentage is from the min for direct drives (battery, comfort) and from the max for inverse drives (boredom)
+        double homeostasisNeed = signDrive > 0 ? percenHomeostasis * (maxNeed - minNeed) + minNeed : maxNeed - (maxNeed - minNeed) * percenHomeostasis;
+
+        extraNeeds.push_back(drives.addNeed(driveName, initNeed, minNeed, maxNeed, homeostasisNeed, rangeNeed, signDrive, gainNeed, decayNeed, true));
+        cout<<"Extra drive "<<driveName<<": min "<<minNeed<<" max "<<maxNeed<<" init "<<initNeed<<" homeostasis "<<homeostasisNeed<<" range "<<rangeNeed
+            <<" sign "<<signDrive<<" gain "<<gainNeed<<" decay "<<decayNeed<<endl;
+    }
 }
 
 void motivationThread::initVarsFromFile(){
@@ -228,6 +247,13 @@ void motivationThread::initVarsFromFile(){
     DRIVE_AFFECT = rf.findGroup("variables").find("DRIVE_AFFECT").asInt32();
     DRIVE_SURVIVE = rf.findGroup("variables").find("DRIVE_SURVIVE").asInt32();
 
+    EXTRA_DRIVES.clear();
+    if(rf.findGroup("variables").find("EXTRA_DRIVES").isList())
+        EXTRA_DRIVES = *rf.findGroup("variables").find("EXTRA_DRIVES").asList();
+
+    PERSIST_OBJECTS_MEMORY = rf.findGroup("variables").check("PERSIST_OBJECTS_MEMORY", Value(0)).asInt32();
+    OBJECTS_MEMORY_HALFLIFE = rf.findGroup("variables").check("OBJECTS_MEMORY_HALFLIFE", Value(43200.0)).asFloat64();
+
     mode = rf.findGroup("variables").find("mode").asString();
     if(mode.compare(LEARNING_PHASE) == 0)
         mode = LEARNING_PHASE;
@@ -264,15 +290,24 @@ void motivationThread::printData(){
     cout<<"DRIVE_BOREDOM: "<<DRIVE_BOREDOM<<endl;
     cout<<"DRIVE_AFFECT: "<<DRIVE_AFFECT<<endl;
     cout<<"DRIVE_SURVIVE: "<<DRIVE_SURVIVE<<endl;
+    cout<<"EXTRA_DRIVES: "<<EXTRA_DRIVES.toString()<<endl;
+    cout<<"PERSIST_OBJECTS_MEMORY: "<<PERSIST_OBJECTS_MEMORY<<endl;
+    cout<<"OBJECTS_MEMORY_HALFLIFE: "<<OBJECTS_MEMORY_HALFLIFE<<endl;
 }
 
 bool motivationThread::threadInit() {
+    configurePeriod(rf.findGroup("periods"), "motivation");
+
     filepath = rf.find("filepath").asString();
     filenameAllData = filepath + filenameAllData;
     filenameAllObjectsMemory = filepath + filenameAllObjectsMemory;
+    filenameObjectsSnapshot = filepath + filenameObjectsSnapshot;
     
     initAllVars();
 
+    if(PERSIST_OBJECTS_MEMORY)
+        loadObjectsSnapshot();
+
     saveHeaders();
 
     if(!openAllPorts())
@@ -302,7 +337,7 @@ void motivationThread::startDrivesComputation(){
     }
 }
 
-void motivationThread::run() {
+void motivationThread::tick() {
     now = time(0);
     char* timeNow_ = ctime(&now);
     timeNow = timeNow_;
@@ -326,9 +361,13 @@ void motivationThread::run() {
         computeAffect();
         computeEnergy();
         computeBoredom();
+        updateDrives();
 
         saveData();
         saveObjectsMemory();
+
+        if(PERSIST_OBJECTS_MEMORY)
+            saveObjectsSnapshot();
     }
     
     writeAllOutputPorts();
@@ -341,24 +380,47 @@ void motivationThread::iCubesProcessing(){
         dataAllCubes = inputiCubesPort.read(false);
         if(dataAllCubes != NULL){
             for(int i = 0; i < dataAllCubes->size(); i++){
-                cout<<"iCube_" <<i<<":  ";
-                cout<<dataAllCubes->get(i).asList()->get(0).asInt32()<<",   [ ";
-                if(dataAllCubes->get(i).asList()->get(1).asList() != NULL)
-                    cout<<dataAllCubes->get(i).asList()->get(1).asList()->get(0).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(1).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(2).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(3).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(4).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(5).asInt32();
-                cout<<"],   "<<dataAllCubes->get(i).asList()->get(2).asString()<<endl;
+                Bottle* cube = dataAllCubes->get(i).asList();
+                unsigned int touchMask = cube->get(ICUBE_TOUCH_MASK).asInt32();
+                cout<<"iCube_" <<i<<":  status "<<cube->get(ICUBE_STATUS).asInt32()<<",   faces touched "<<countTouchedFaces(touchMask)<<" (mask "<<touchMask<<"),   "<<cube->get(ICUBE_POSE).asString()<<endl;
             }
         }else
             cout<<"Perception/iCubes:o DID NOT send data"<<endl;
     }
 }
 
-float motivationThread::computeDrive(float need, int homeostasis_base, int range){
-    if((need >= (homeostasis_base - range)) && (need <= (homeostasis_base + range)))//Homeostasis
-        return 0;
-    else if(need < homeostasis_base)
-        return -((homeostasis_base - range) - need);//Consider the lowerBound
-    else
-        return -((homeostasis_base + range) - need);//Consider the upperBound
+void motivationThread::readNeedsStimuli(){
+    if(inputNeedsStimuliPort.getInputCount()){
+        Bottle* stimuli = nullptr;
+        stimuli = inputNeedsStimuliPort.read(false);
+        if(stimuli != nullptr){
+            for(int i = 0; i + 1 < stimuli->size(); i += 2){
+                int index = drives.getIndex(stimuli->get(i).asString());
+                if(index != NO_NEED)
+                    drives.addStimulus(index, stimuli->get(i + 1).asFloat64());
+                else
+                    yWarning("stimulus for an unknown need %s", stimuli->get(i).asString().c_str());
+            }
+        }
+    }
+}
+
+//Copy the built-in needs into the drives table and update all the drives in one pass
+void motivationThread::updateDrives(){
+    readNeedsStimuli();
+
+    drives.setValue(needComfort, comfort_current);
+    drives.setValue(needBattery, batteryLevel);
+    drives.setValue(needBoredom, boredom);
+
+    drives.update();
+
+    affectDrive = drives.getDrive(needComfort);
+    surviveDrive = drives.getDrive(needBattery);
+    exploreDrive = drives.getDrive(needBoredom);
+
+    for(int i = 0; i < extraNeeds.size(); i++)
+        cout<<drives.getName(extraNeeds[i])<<": "<<drives.getValue(extraNeeds[i])<<" drive: "<<drives.getDrive(extraNeeds[i])<<endl;
 }
 
 float motivationThread::comfortProcessing(){
@@ -412,11 +474,9 @@ void motivationThread::computeAffect(){
         comfort_current = comfortProcessing();
         cout<<"Comfort level "<< comfort_current <<endl;
 
-        affectDrive = computeDrive(comfort_current, AFFECT_HOMEOSTASIS, RANGE_AFFECT);
-
         comfort_prev = comfort_current;
-    }else
-        affectDrive = 0;//If not using this drive, consider it is already satisfied (to desconsider as an option in the Decision Making)
+    }
+    //If not using this drive, the drive engine considers it is already satisfied (to desconsider as an option in the Decision Making)
 }
 
 //Battery decrease in time and increase when recharge.
@@ -425,11 +485,9 @@ void motivationThread::computeEnergy(){
         if(inputBatteryLevelPort.getInputCount()){
             Bottle* inputBattery = inputBatteryLevelPort.read(true);
             batteryLevel = inputBattery->get(0).asFloat64();
-
-            surviveDrive = computeDrive(batteryLevel, SURVIVAL_HOMEOSTASIS, RANGE_SURVIVE);
         }
-    }else
-        surviveDrive = 0;//If not using this drive, consider it is already satisfied (to desconsider as an option in the Decision Making)
+    }
+    //If not using this drive, the drive engine considers it is already satisfied (to desconsider as an option in the Decision Making)
 }
 
 //Boredom increase in time and decrease when play with the objects
@@ -471,12 +529,9 @@ void motivationThread::computeBoredom(){
             }
         }
         cout<<"Boredom: "<<boredom<<endl;
-        exploreDrive = computeDrive(boredom, EXPLORE_HOMEOSTASIS, RANGE_EXPLORE); 
-        if(exploreDrive != 0)
-            exploreDrive *= (-1);// *-1 because the direction of increase/decrease is the opposite of the other drives
-        
-    }else
-        exploreDrive = 0;//If not using this drive, consider it is already satisfied (to desconsider as an option in the Decision Making)
+    }
+    //The explore drive has DRIVE_SIGN_INVERSE because the direction of increase/decrease is the opposite of the other drives
+    //If not using this drive, the drive engine considers it is already satisfied (to desconsider as an option in the Decision Making)
 }
 
 void motivationThread::updateObjectMemory(){
@@ -498,6 +553,7 @@ void motivationThread::updateObjectMemory(){
                 for(int j = 0; j < allObjectsMemory.size(); j++){
                     if(allObjectsMemory[j].color.compare(objectsScene->get(i+1).asList()->get(8).asString()) == 0){
                         allObjectsMemory[j].seeing = true;
+                        allObjectsMemory[j].lastSeen = time(0);
                         newObject = false;
                         break;
                     }
@@ -507,6 +563,7 @@ void motivationThread::updateObjectMemory(){
                     data.color = objectsScene->get(i+1).asList()->get(8).asString();
                     data.value = 0;
                     data.seeing = true;
+                    data.lastSeen = time(0);
                     allObjectsMemory.push_back(data);
                 }
             }
@@ -561,7 +618,10 @@ void motivationThread::saveHeaders(){
     ofstream fout; 
     
     fout.open(filenameAllData, ios::app);
-    fout << fileHeaderAllData << "\n";
+    fout << fileHeaderAllData;
+    for(int i = 0; i < extraNeeds.size(); i++)
+        fout << ',' << drives.getName(extraNeeds[i]) << ',' << drives.getName(extraNeeds[i]) << "Drive";
+    fout << "\n";
     fout.close( );
 
     fout.open(filenameAllObjectsMemory, ios::app); 
@@ -578,6 +638,8 @@ void motivationThread::saveData(){
     << to_string(EXPLORE_HOMEOSTASIS) << ',' << to_string(RANGE_EXPLORE) <<',' << to_string(AFFECT_HOMEOSTASIS) << ',' << to_string(RANGE_AFFECT)
     <<',' << to_string(SURVIVAL_HOMEOSTASIS) << ',' << to_string(RANGE_SURVIVE) << ','
     << to_string(exploreDrive) << ',' << to_string(affectDrive) << ',' << to_string(surviveDrive) << ',' << to_string(indexObjChoosen);
+    for(int i = 0; i < extraNeeds.size(); i++)
+        fout << ',' << to_string(drives.getValue(extraNeeds[i])) << ',' << to_string(drives.getDrive(extraNeeds[i]));
     
     fout <<"\n";
     fout.close();
@@ -596,83 +658,150 @@ void motivationThread::saveObjectsMemory(){
     }
 }
 
-void motivationThread::writeAllOutputPorts(){
-    if(outputExploreDriveAndObject.getOutputCount()){
-        Bottle obj;
-        obj.clear();
-        obj.addFloat64(exploreDrive);
-        if(indexObjChoosen != NON_EXIST){
-            cout<<"Color choosen: "<<allObjectsMemory[indexObjChoosen].color<<endl;
-            obj.addString(allObjectsMemory[indexObjChoosen].color);
-        }else
-            obj.addString("");
-        outputExploreDriveAndObject.prepare() = obj;
-        outputExploreDriveAndObject.write();
+/*  Snapshot layout (native endianness, written by this module only):
+    uint32 magic, uint32 version, float64 timeSaved, uint32 numberOfObjects
+    for each object: uint16 colorLength, char color[colorLength], float64 value, float64 lastSeen
+*/
+bool motivationThread::saveObjectsSnapshot(){
+    string tmpFilename = filenameObjectsSnapshot + ".tmp";
+    ofstream fout(tmpFilename, ios::binary | ios::trunc);
+    if(!fout.is_open()){
+        yWarning("unable to write the objects memory snapshot %s", tmpFilename.c_str());
+        return false;
     }
 
-    if(outputSurvivalDrivePort.getOutputCount()){
-        Bottle batteryBottle;
-        batteryBottle.clear();
-        batteryBottle.addFloat64(surviveDrive);
-        outputSurvivalDrivePort.prepare() = batteryBottle;
-        outputSurvivalDrivePort.write();
+    uint32_t magic = SNAPSHOT_MAGIC;
+    uint32_t version = SNAPSHOT_VERSION;
+    double timeSaved = time(0);
+    uint32_t numberOfObjects = allObjectsMemory.size();
+
+    fout.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    fout.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    fout.write(reinterpret_cast<const char*>(&timeSaved), sizeof(timeSaved));
+    fout.write(reinterpret_cast<const char*>(&numberOfObjects), sizeof(numberOfObjects));
+
+    for(int i = 0; i < allObjectsMemory.size(); i++){
+        uint16_t colorLength = allObjectsMemory[i].color.size();
+        fout.write(reinterpret_cast<const char*>(&colorLength), sizeof(colorLength));
+        fout.write(allObjectsMemory[i].color.data(), colorLength);
+        fout.write(reinterpret_cast<const char*>(&allObjectsMemory[i].value), sizeof(double));
+        fout.write(reinterpret_cast<const char*>(&allObjectsMemory[i].lastSeen), sizeof(double));
     }
+    fout.close();
+
+    //replace the old snapshot just when the new one is complete (a crash while writing keeps the previous one)
+    if(fout.fail() || std::rename(tmpFilename.c_str(), filenameObjectsSnapshot.c_str()) != 0){
+        yWarning("unable to update the objects memory snapshot %s", filenameObjectsSnapshot.c_str());
+        return false;
+    }
+    return true;
+}
+
+//Restore the objects memory from the last session. The interest spent in each object decays with the time the robot was off
+bool motivationThread::loadObjectsSnapshot(){
+    ifstream fin(filenameObjectsSnapshot, ios::binary);
+    if(!fin.is_open()){
+        cout<<"No objects memory snapshot in "<<filenameObjectsSnapshot<<". Starting with an empty memory"<<endl;
+        return false;
+    }
+
+    uint32_t magic, version, numberOfObjects;
+    double timeSaved;
 
-    if(outputAffectDrivePort.getOutputCount()){
-        Bottle affectBottle;
-        affectBottle.clear();
-        affectBottle.addFloat64(affectDrive);
-        outputAffectDrivePort.prepare() = affectBottle;
-        outputAffectDrivePort.write();
+    fin.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    fin.read(reinterpret_cast<char*>(&version), sizeof(version));
+    fin.read(reinterpret_cast<char*>(&timeSaved), sizeof(timeSaved));
+    fin.read(reinterpret_cast<char*>(&numberOfObjects), sizeof(numberOfObjects));
+
+    if(!fin || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION){
+        yWarning("invalid objects memory snapshot %s. Starting with an empty memory", filenameObjectsSnapshot.c_str());
+        return false;
     }
 
-    /// DEBUG
-    if(outputBoredomPort.getOutputCount()){
-        Bottle boredomBottle;
-        boredomBottle.clear();
-        boredomBottle.addFloat64(boredom);
-        outputBoredomPort.prepare() = boredomBottle;
-        outputBoredomPort.write();
+    double downtime = max(0.0, (double)time(0) - timeSaved);
+    double decay = 1.0;
+    if(OBJECTS_MEMORY_HALFLIFE > 0)
+        decay = pow(0.5, downtime / OBJECTS_MEMORY_HALFLIFE);
+
+    vector<objects> restored;
+    restored.reserve(numberOfObjects);
+
+    for(uint32_t i = 0; i < numberOfObjects; i++){
+        uint16_t colorLength;
+        objects data;
+
+        fin.read(reinterpret_cast<char*>(&colorLength), sizeof(colorLength));
+        data.color.resize(colorLength);
+        fin.read(&data.color[0], colorLength);
+        fin.read(reinterpret_cast<char*>(&data.value), sizeof(double));
+        fin.read(reinterpret_cast<char*>(&data.lastSeen), sizeof(double));
+
+        if(!fin){
+            yWarning("truncated objects memory snapshot %s. Starting with an empty memory", filenameObjectsSnapshot.c_str());
+            return false;
+        }
+
+        data.value = data.value * decay;
+        data.seeing = false;
+        restored.push_back(data);
     }
 
-    if(outputComfortPort.getOutputCount()){
-        Bottle comfortBottle;
-        comfortBottle.clear();
-        comfortBottle.addFloat64(comfort_current);
-        outputComfortPort.prepare() = comfortBottle;
-        outputComfortPort.write();
+    allObjectsMemory = restored;
+    cout<<"Objects memory restored: "<<allObjectsMemory.size()<<" objects, robot off for "<<downtime<<"s (decay "<<decay<<")"<<endl;
+
+    return true;
+}
+
+//All the drives and needs of the same step go in one message, so the decision making never mixes values of different steps
+void motivationThread::writeAllOutputPorts(){
+    if(outputDriveStatePort.getOutputCount()){
+        Bottle& state = outputDriveStatePort.prepare();
+        state.clear();
+        state.addFloat64(exploreDrive);
+        state.addFloat64(surviveDrive);
+        state.addFloat64(affectDrive);
+        state.addFloat64(boredom);
+        state.addFloat64(comfort_current);
+        state.addFloat64(batteryLevel);
+        if(indexObjChoosen != NON_EXIST){
+            cout<<"Color choosen: "<<allObjectsMemory[indexObjChoosen].color<<endl;
+            state.addString(allObjectsMemory[indexObjChoosen].color);
+        }else
+            state.addString("");
+        for(int i = 0; i < extraNeeds.size(); i++)
+            state.addFloat64(drives.getDrive(extraNeeds[i]));
+
+        driveStateStamp.update();
+        outputDriveStatePort.setEnvelope(driveStateStamp);
+        outputDriveStatePort.write();
     }
 }
 
 void motivationThread::threadRelease() {
+    if(PERSIST_OBJECTS_MEMORY)
+        saveObjectsSnapshot();
+
     inputAllObjects.interrupt();
     inputBatteryLevelPort.interrupt();
     inputInteractionPort.interrupt();
-    outputExploreDriveAndObject.interrupt();
-    outputSurvivalDrivePort.interrupt();
-    outputAffectDrivePort.interrupt();
+    outputDriveStatePort.interrupt();
     inputUpdateBoredomPort.interrupt();
     inputPortResetBoredomComfort.interrupt();
     inputPortEndInitialBehavior.interrupt();
     inputPortSaturetedAffect.interrupt();
     inputiCubesPort.interrupt();
-
-    outputBoredomPort.interrupt();
-    outputComfortPort.interrupt();
-    outputBoredomPort.close();
-    outputComfortPort.close();
+    inputNeedsStimuliPort.interrupt();
 
     inputAllObjects.close();
     inputBatteryLevelPort.close();
     inputInteractionPort.close();
-    outputExploreDriveAndObject.close();
-    outputSurvivalDrivePort.close();
-    outputAffectDrivePort.close();
+    outputDriveStatePort.close();
     inputUpdateBoredomPort.close();
     inputPortResetBoredomComfort.close();
     inputPortEndInitialBehavior.close();
     inputPortSaturetedAffect.close();
     inputiCubesPort.close();
+    inputNeedsStimuliPort.close();
 }
 
 //-------------- ARTIFICIAL SOLUTION WHEN THE DRIVE IS MAXIMUM FOR A LONG TIME AND "CANNOT" BE SOLVED DURING INTERACTION -----------//
@@ -49,7 +49,7 @@ class perceptionModule:public yarp::os::RFModule {
     
     yarp::os::Port handlerPort;              // a port to handle messages 
     /*  */
-    perceptionThread *pThread;             // pointer to a new thread to be created and started in configure() and stopped in close()
+    perceptionThread *pThread = nullptr; // pointer to a new thread to be created and started in configure() and stopped in close()
 
 public:
     /**
@@ -42,7 +42,12 @@
 #include <boost/algorithm/string.hpp>
 #include <string.h>
 
-class perceptionThread : public yarp::os::PeriodicThread {
+#include "iCub/iCubeTouch.h"
+#include "iCub/skinTouch.h"
+#include "iCub/monitoredThread.h"
+#include "iCub/taskPool.h"
+
+class perceptionThread : public monitoredThread {
 private:
 
     std::string robot;              // name of the robot
@@ -65,7 +70,7 @@ private:
     std::string fileHeaderAllObjects = "time,durationExp,objectColor,topLeftX_leftCam,topLeftY_leftCam,bottomRightX_leftCam,bottomRightY_leftCam,topLeftX_rightCam,topLeftY_rightCam,bottomRightX_rightCam,bottomRightY_rightCam";
 
     std::string filenameAllICubes = "perception_iCubes.csv";
-    std::string fileHeaderAllICubes = "time,durationExp,iCubeNumber,numberFacesTouched,face_0,face_1,face_2,face_3,face_4,face_5,pose";
+    std::string fileHeaderAllICubes = "time,durationExp,iCubeNumber,status,touchMask,numberFacesTouched,pose";
 
     int numberOfObjectsL, numberOfObjectsR;
 
@@ -83,6 +88,27 @@ private:
 
     std::vector<BlobsImage> imageBlobs_bothCameras;
 
+    //Result of a step, written to the ports and the csv (while the next step reads the sensors)
+    typedef struct perceptionOutput_{
+        std::string timeNow;
+        double durationExp;
+        std::time_t durationExpICubes;
+        double batteryLevel;
+        float touch_current;
+        int originOfTouch, sideOfTouch;
+        int faceSuccessInput;
+        double faceCertInput, faceXInput, faceYInput, faceDepthInput, focusX, focusY;
+        bool gazeInput;
+        std::string affectInput;
+        float face_current, gaze_current;
+        std::vector<BlobsImage> objects;
+        bool hasICubes;
+        yarp::os::Bottle iCubes;                //copy, the port reuses its buffer at the next read
+    }perceptionOutput;
+
+    taskPool sensors;                           //reads the independent sensors of a step in parallel
+    taskPool outputs;                           //one step of output at a time, in order
+
     yarp::os::Bottle* inputBlobsListL;
     yarp::os::Bottle* inputBlobsListR;
 
@@ -107,6 +133,7 @@ private:
     bool gazeInput;
     int faceSuccessInput;
     std::string affectInput;
+    std::string affectMessage;          //of the last evaluation read, printed after the sensors
     float gaze_current, gaze_prev, face_current, face_prev;
 
     //Constants that can be changed according to each experiment. The default values are for Sara's experiments
@@ -142,7 +169,7 @@ private:
     yarp::os::BufferedPort<yarp::os::Bottle> outputGazeFaceSkinPort;        //write face_current, gaze_current, touch_current
     yarp::os::BufferedPort<yarp::os::Bottle> outputSkinPort;                //write originOfTouch, sideOfTouch
     yarp::os::BufferedPort<yarp::os::Bottle> outputAffectPort;              //write affectInput, focusX, focusY
-    yarp::os::BufferedPort<yarp::os::Bottle> outputiCubesPort;              //write touchedFaces, facesBeingTouched, pose of each iCube
+    yarp::os::BufferedPort<yarp::os::Bottle> outputiCubesPort;              //write status, touchMask, pose of each iCube
 
     std::string name;                                                                // rootname of all the ports opened by this thread
     
@@ -176,7 +203,7 @@ public:
     /**
     *  active part of the thread
     */
-    void run(); 
+    void tick() override;
 
     /**
     * function that sets the rootname of all the ports that are going to be created by the thread
@@ -203,8 +230,11 @@ public:
 
     bool openAllPorts();
     void initAllVars();
-    void writeAllOutputPorts();
-    void saveData();
+    void readSensors();
+    void printSensors();
+    perceptionOutput getOutput();
+    void writeAllOutputPorts(const perceptionOutput& output);
+    void saveData(const perceptionOutput& output);
     void saveHeaders();
     
     //Functions related to object perception -- Can detect a variable amount of objects in the scene using both cameras or just one
@@ -215,16 +245,22 @@ public:
     void detectObjectsL();
     void printListOfObjectsL();
     void printListOfAllObjects();
-    void saveDataObjects();
+    void printObjects();
+    void saveDataObjects(const perceptionOutput& output);
+
+    //decay of the touch, face and gaze activations in one cycle of the current period
+    float decayOfSensors();
 
     //Functions related to skin touch perception
+    std::string skinMessage;            //last event read, printed after the sensors
     bool readSkin();
     float perceptSkin();
     float processTactileStimuli();
 
     //Functions related to iCube perception
     void perceptICube();
-    void saveDataICubes();
+    void printICubes();
+    void saveDataICubes(const perceptionOutput& output);
     
     //Functions related to the openFace perception
     void perceptAffect();
@@ -33,16 +33,16 @@ using namespace boost;
 #define THPERIOD 0.5 //s
 #define NON_EXIST -1
 
-perceptionThread::perceptionThread():PeriodicThread(THPERIOD) {
+perceptionThread::perceptionThread():monitoredThread(THPERIOD) {
     robot = "icub";        
 }
 
-/* perceptionThread::perceptionThread(string _robot, string _configFile):PeriodicThread(THPERIOD){
+/* perceptionThread::perceptionThread(string _robot, string _configFile):monitoredThread(THPERIOD){
     robot = _robot;
     configFile = _configFile;
 } */
 
-perceptionThread::perceptionThread(string _robot, ResourceFinder &_rf):PeriodicThread(THPERIOD){
+perceptionThread::perceptionThread(string _robot, ResourceFinder &_rf):monitoredThread(THPERIOD){
     robot = _robot;
     rf = _rf;
 }
@@ -165,6 +165,11 @@ void perceptionThread::initAllVars(){
     focusX = 0.0;
     focusY = 0.0;
 
+    gazeInput = false;
+
+    //iCube
+    dataAllCubes = nullptr;
+
     // VARIABLES FOR INTERNAL STATES
     touch_current = 0.0;
     touch_prev = 0.0;
@@ -175,6 +180,8 @@ void perceptionThread::initAllVars(){
 }
 
 bool perceptionThread::threadInit(){
+    configurePeriod(rf.findGroup("periods"), "perception");
+
     filepath = rf.find("filepath").asString();
     cout<<"filepath: "<<filepath<<endl;
     filenameAllData = filepath + filenameAllData;
@@ -188,6 +195,12 @@ bool perceptionThread::threadInit(){
     if(!openAllPorts())
         return false;
 
+    Bottle& variables = rf.findGroup("variables");
+    sensors.start(variables.check("PERCEPTION_WORKERS", Value(2)).asInt32());
+    //under the executor the readers of the outputs run right after this tick, they are written before it ends
+    bool asyncOutput = variables.check("PERCEPTION_ASYNC_OUTPUT", Value(1)).asInt32() == 1 && !isCooperative();
+    outputs.start(asyncOutput ? 1 : 0);
+
     yInfo("Initialization of the processing thread correctly ended");
     
     timeInitial = Time::now();
@@ -207,51 +220,28 @@ bool perceptionThread::readSkin(){
 
     if(skinData != nullptr){
         string skinInput = skinData->toString();
-        cout << skinInput << endl;
+        skinMessage = skinInput;
 
         skinData->clear();
-        vector<string> fields;
-
-        split(fields, skinInput, is_any_of( " " ), token_compress_on);
-        cout << "skin origin: " << fields[0][1] << endl;
-
-        if(fields.size() == 3 && stod(fields[1]) > 5.0 && stod(fields[2]) > 7.0){ //fields.size() == 3 to avoid cases when the robot "feels" a touch that doesnt exist (has the value but not the origin)
-            okTouch = true;
-
-            if(fields[0][1] == 't'){//torso
-                sideOfTouch = torsoS;
-                originOfTouch = torso;
-            }
-
-            if(fields[0][1] == 'l'){//left arm
-                sideOfTouch = leftS;
-                if(fields[0][2] == 'h')//hand 
-                    originOfTouch = leftHand;  
-                else if(fields[0][2] == 'f')//forearm 
-                    originOfTouch = leftForearm;   
-                else
-                    originOfTouch = leftUpper;//upper arm
-            }
 
-            if(fields[0][1] == 'r'){//right arm
-                sideOfTouch = rightS;
-                if(fields[0][2] == 'h')//hand  
-                    originOfTouch = rightHand;  
-                else if(fields[0][2] == 'f')//forearm 
-                    originOfTouch = rightForearm;   
-                else 
-                    originOfTouch = rightUpper;//upper arm
-            }
-        }
+        int origin, side;
+        okTouch = parseSkinTouch(skinInput, origin, side);
+        originOfTouch = (bodyPart)origin;
+        sideOfTouch = (bodySide)side;
     }
     return okTouch;
 }
 
+//alpha_sensors is the decay of one nominal period, the cycles of an adaptive (or executor) period decay as much per second
+float perceptionThread::decayOfSensors(){
+    return pow(alpha_sensors, getPeriod() / getNominalPeriod());
+}
+
 float perceptionThread::processTactileStimuli(){
     if(readSkin())
         touch_current = touchMaxActivation;
     else
-        touch_current = alpha_sensors * touch_prev;
+        touch_current = decayOfSensors() * touch_prev;
 
     if(touch_current < minThresholdTouch) //0.01, maybe try with 0.25/0.5
         touch_current = 0.0;
@@ -274,7 +264,7 @@ float perceptionThread::processFaceStimuli(){
     else if(affectInput.compare("smiling") == 0)
         face_current = SMILING;
     else
-        face_current = alpha_sensors * face_prev;
+        face_current = decayOfSensors() * face_prev;
 
     if(face_current < maxThresholdFace && face_current > minThresholdFace)
         face_current = 0.0;
@@ -293,7 +283,7 @@ float perceptionThread::processGazeStimuli(){
     if(gazeInput)
         gaze_current = gazeMaxActivation;
     else
-        gaze_current = alpha_sensors * gaze_prev;
+        gaze_current = decayOfSensors() * gaze_prev;
 
     if(gaze_current < minThresholdGaze) //0.01, maybe try with 0.25/0.5
         gaze_current = 0.0;
@@ -314,9 +304,9 @@ void perceptionThread::readAffectEvaluation(){
         faceDepthInput = bottleAffect->get(5).asFloat64();
 
         if(faceSuccessInput == 1 && faceCertInput > 0.7)
-            cout << "FACE CERTAIN\n";
+            affectMessage = "FACE CERTAIN";
         else{
-            cout << "NO FACE\n";
+            affectMessage = "NO FACE";
             affectInput = "unreliable";
             faceSuccessInput = 0;
             faceCertInput = 0.0;
@@ -454,29 +444,35 @@ void perceptionThread::perceptObject(){
     numberOfObjectsR = 0;
     imageBlobs_bothCameras.clear();
 
-    if(inputPortBlobsListL.getInputCount()){
+    if(inputPortBlobsListL.getInputCount())
         detectObjectsL();
-        printListOfObjectsL(); 
-    }
 
-    if(inputPortBlobsListR.getInputCount()){
+    if(inputPortBlobsListR.getInputCount())
         detectObjectsR();
-        printListOfObjectsR();   
-    }
- 
+}
+
+void perceptionThread::printObjects(){
+    if(inputPortBlobsListL.getInputCount())
+        printListOfObjectsL();
+
+    if(inputPortBlobsListR.getInputCount())
+        printListOfObjectsR();
+
     printListOfAllObjects();
 }
 
 void perceptionThread::perceptICube(){
-    if(inputPortiCube.getInputCount()){
+    if(inputPortiCube.getInputCount())
         dataAllCubes = inputPortiCube.read(false);
+}
+
+void perceptionThread::printICubes(){
+    if(inputPortiCube.getInputCount()){
         if(dataAllCubes != NULL){
             for(int i = 0; i < dataAllCubes->size(); i++){
-                cout<<"iCube_" <<i<<":  ";
-                cout<<dataAllCubes->get(i).asList()->get(0).asInt32()<<",   [ ";
-                if(dataAllCubes->get(i).asList()->get(1).asList() != NULL)
-                    cout<<dataAllCubes->get(i).asList()->get(1).asList()->get(0).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(1).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(2).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(3).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(4).asInt32()<<"  "<<dataAllCubes->get(i).asList()->get(1).asList()->get(5).asInt32();
-                cout<<"],   "<<dataAllCubes->get(i).asList()->get(2).asString()<<endl;
+                Bottle* cube = dataAllCubes->get(i).asList();
+                unsigned int touchMask = cube->get(ICUBE_TOUCH_MASK).asInt32();
+                cout<<"iCube_" <<i<<":  status "<<cube->get(ICUBE_STATUS).asInt32()<<",   faces touched "<<countTouchedFaces(touchMask)<<" (mask "<<touchMask<<"),   "<<cube->get(ICUBE_POSE).asString()<<endl;
             }
         }else
             cout<<"iCubeProcessor DID NOT send data"<<endl;
@@ -493,7 +489,7 @@ void perceptionThread::iCub_eyesOpen(){
     }
 }
 
-void perceptionThread::run(){
+void perceptionThread::tick(){
     now = time(0);
     char* timeNow_ = ctime(&now);
     timeNow = timeNow_;
@@ -502,17 +498,57 @@ void perceptionThread::run(){
     iCub_eyesOpen();
     cout<<"eyesOpen?: "<<eyesOpen<<endl;
 
+    readSensors();
+
+    cout<<"Face detected "<<face_current<<endl;
+    cout<<"Touch detected "<<touch_current<<endl;
+    cout<<"Gaze level "<<gaze_current<<endl;
+
+    //the ports and the csv of this step are written while the next step reads the sensors
+    outputs.wait();
+    perceptionOutput output = getOutput();
+    outputs.post([this, output]{
+        writeAllOutputPorts(output);
+        saveData(output);
+        saveDataObjects(output);
+        saveDataICubes(output);
+    });
+    //without the output worker the write is done in this step, not at the start of the next one
+    if(outputs.getNumberOfWorkers() == 0)
+        outputs.wait();
+
+    //time++;
+    
+    touch_prev = touch_current;
+    face_prev = face_current;
+    gaze_prev = gaze_current;
+
+    //faster while there is a person (face or touch); never slower than the nominal period, motivation reads
+    //the outputs blocking and its comfort and boredom change at each of its steps
+    if(eyesOpen && (faceSuccessInput != 0 || touch_current != 0.0))
+        requestFastPeriod();
+    else
+        requestNominalPeriod();
+
+    cout<<"----------------------------"<<endl;
+}
+
+//Each sensor is one task: they read different ports and set different variables, the step waits for all of them
+void perceptionThread::readSensors(){
+    affectMessage = "";
+    skinMessage = "";
+
     //Stuff related to vision
     if(eyesOpen){
-        //read Facial Expression and generate FaceSuccessInput
-        perceptAffect();
-
-        //check if face is still in scene
-        face_current = processFaceStimuli();
-        gaze_current = processGazeStimuli();
+        //read Facial Expression and generate FaceSuccessInput, then check if face is still in scene
+        sensors.post([this]{
+            perceptAffect();
+            face_current = processFaceStimuli();
+            gaze_current = processGazeStimuli();
+        });
 
         //process if there are objects in the scene using color segmentation
-        perceptObject();
+        sensors.post([this]{ perceptObject(); });
     }else{
         //Not seeing person
         affectInput = "noFace";
@@ -530,40 +566,65 @@ void perceptionThread::run(){
     }
 
     //process stimuli from touch
-    touch_current = perceptSkin();
+    sensors.post([this]{ touch_current = perceptSkin(); });
 
     //read the battery value (battery is a simulated sensor)
-    perceptBattery();
+    sensors.post([this]{ perceptBattery(); });
 
     //read if there are iCubes in the setup and if they are being touched
-    if(dataAllCubes != NULL)
-        dataAllCubes->clear();
-    perceptICube();
-
-    cout<<"Face detected "<<face_current<<endl;
-    cout<<"Touch detected "<<touch_current<<endl;
-    cout<<"Gaze level "<<gaze_current<<endl;
-
-    writeAllOutputPorts();
-
-    saveData();
-    saveDataObjects();
-    saveDataICubes();
-
-    //time++;
-    
-    touch_prev = touch_current;
-    face_prev = face_current;
-    gaze_prev = gaze_current;
-
-    cout<<"----------------------------"<<endl;
-}
-
-void perceptionThread::writeAllOutputPorts(){
+    sensors.post([this]{
+        if(dataAllCubes != NULL)
+            dataAllCubes->clear();
+        perceptICube();
+    });
+
+    sensors.wait();
+    printSensors();
+}
+
+//the tasks share cout, what they read is printed here, in the order of the tasks
+void perceptionThread::printSensors(){
+    if(!affectMessage.empty())
+        cout << affectMessage << endl;
+    if(eyesOpen)
+        printObjects();
+    if(!skinMessage.empty())
+        cout << skinMessage << endl;
+    printICubes();
+}
+
+perceptionThread::perceptionOutput perceptionThread::getOutput(){
+    perceptionOutput output;
+    output.timeNow = timeNow;
+    output.durationExp = Time::now() - timeInitial;
+    output.durationExpICubes = (std::time_t)Time::now() - timeInitial;
+    output.batteryLevel = batteryLevel;
+    output.touch_current = touch_current;
+    output.originOfTouch = originOfTouch;
+    output.sideOfTouch = sideOfTouch;
+    output.faceSuccessInput = faceSuccessInput;
+    output.faceCertInput = faceCertInput;
+    output.faceXInput = faceXInput;
+    output.faceYInput = faceYInput;
+    output.faceDepthInput = faceDepthInput;
+    output.focusX = focusX;
+    output.focusY = focusY;
+    output.gazeInput = gazeInput;
+    output.affectInput = affectInput;
+    output.face_current = face_current;
+    output.gaze_current = gaze_current;
+    output.objects = imageBlobs_bothCameras;
+    output.hasICubes = dataAllCubes != NULL;
+    if(output.hasICubes)
+        output.iCubes = *dataAllCubes;
+    return output;
+}
+
+void perceptionThread::writeAllOutputPorts(const perceptionOutput& output){
     if(outputBatteryPort.getOutputCount()){
         Bottle batteryBottle;
         batteryBottle.clear();
-        batteryBottle.addFloat64(batteryLevel);
+        batteryBottle.addFloat64(output.batteryLevel);
         outputBatteryPort.prepare() = batteryBottle;
         outputBatteryPort.write();
     }
@@ -573,10 +634,10 @@ void perceptionThread::writeAllOutputPorts(){
         Bottle objs;
         
         allObjSeen.clear();
-        allObjSeen.addInt16(imageBlobs_bothCameras.size());
+        allObjSeen.addInt16(output.objects.size());
         
-        if(imageBlobs_bothCameras.size() > 0){    
-            for (auto element : imageBlobs_bothCameras){
+        if(output.objects.size() > 0){    
+            for (auto element : output.objects){
                 objs.clear();
                 objs.addInt16(element.topLeftX_leftCam);
                 objs.addInt16(element.topLeftY_leftCam);
@@ -598,9 +659,9 @@ void perceptionThread::writeAllOutputPorts(){
     if (outputGazeFaceSkinPort.getOutputCount()){
         Bottle motivationInput;
         motivationInput.clear();
-        motivationInput.addFloat64(face_current);
-        motivationInput.addFloat64(gaze_current);
-        motivationInput.addFloat64(touch_current);
+        motivationInput.addFloat64(output.face_current);
+        motivationInput.addFloat64(output.gaze_current);
+        motivationInput.addFloat64(output.touch_current);
         outputGazeFaceSkinPort.prepare() = motivationInput;
         outputGazeFaceSkinPort.write();
     }
@@ -608,8 +669,8 @@ void perceptionThread::writeAllOutputPorts(){
     if (outputSkinPort.getOutputCount()){
         yarp::os::Bottle outputSkin;
         outputSkin.clear();
-        outputSkin.addInt16(originOfTouch);
-        outputSkin.addInt16(sideOfTouch);
+        outputSkin.addInt16(output.originOfTouch);
+        outputSkin.addInt16(output.sideOfTouch);
         outputSkinPort.prepare() = outputSkin;
         outputSkinPort.write();
     }
@@ -617,9 +678,10 @@ void perceptionThread::writeAllOutputPorts(){
     if (outputAffectPort.getOutputCount()){
         yarp::os::Bottle outputAffect;
         outputAffect.clear();
-        outputAffect.addString(affectInput);
-        outputAffect.addFloat64(focusX);
-        outputAffect.addFloat64(focusY);
+        outputAffect.addString(output.affectInput);
+        outputAffect.addFloat64(output.focusX);
+        outputAffect.addFloat64(output.focusY);
+        outputAffect.addInt16(output.gazeInput);   //focusX and focusY are from a face seen in this step
         outputAffectPort.prepare() = outputAffect;
         outputAffectPort.write();
     }
@@ -642,28 +704,28 @@ void perceptionThread::saveHeaders(){
     fout.close( );
 }
 
-void perceptionThread::saveData(){
+void perceptionThread::saveData(const perceptionOutput& output){
     ofstream fout;
     fout.open(filenameAllData, ios::app);
     
-    fout << timeNow << ',' << to_string(Time::now() - timeInitial) << ',' << to_string(batteryLevel) << ',' << to_string(touch_current) << ',' << to_string(originOfTouch) << ',' << to_string(sideOfTouch) << ',' <<
-        to_string(faceSuccessInput) << ',' <<  to_string(faceCertInput) << ',' << affectInput << ',' << to_string(faceXInput) << ',' << to_string(faceYInput) 
-        << ',' << to_string(faceDepthInput) << ',' << to_string(face_current) << ',' << to_string(gaze_current);
+    fout << output.timeNow << ',' << to_string(output.durationExp) << ',' << to_string(output.batteryLevel) << ',' << to_string(output.touch_current) << ',' << to_string(output.originOfTouch) << ',' << to_string(output.sideOfTouch) << ',' <<
+        to_string(output.faceSuccessInput) << ',' <<  to_string(output.faceCertInput) << ',' << output.affectInput << ',' << to_string(output.faceXInput) << ',' << to_string(output.faceYInput) 
+        << ',' << to_string(output.faceDepthInput) << ',' << to_string(output.face_current) << ',' << to_string(output.gaze_current);
     
     fout <<"\n";
     fout.close();
 }
                 
-void perceptionThread::saveDataObjects(){
+void perceptionThread::saveDataObjects(const perceptionOutput& output){
     ofstream fout;
     
-    if(imageBlobs_bothCameras.size() > 0){
+    if(output.objects.size() > 0){
         fout.open(filenameAllObjects, ios::app);
 
-        for(int i = 0; i < imageBlobs_bothCameras.size(); i++){
-            fout << timeNow << ',' << to_string(Time::now() - timeInitial) << ',' << imageBlobs_bothCameras[i].color << ',' 
-                << to_string(imageBlobs_bothCameras[i].topLeftX_leftCam) << ',' << to_string(imageBlobs_bothCameras[i].topLeftY_leftCam) << ',' << to_string(imageBlobs_bothCameras[i].bottomRightX_leftCam) << ',' << to_string(imageBlobs_bothCameras[i].bottomRightY_leftCam) << ',' 
-                << to_string(imageBlobs_bothCameras[i].topLeftX_rightCam) << ',' << to_string(imageBlobs_bothCameras[i].topLeftY_rightCam) << ',' << to_string(imageBlobs_bothCameras[i].bottomRightX_rightCam) << ',' << to_string(imageBlobs_bothCameras[i].bottomRightY_rightCam);
+        for(int i = 0; i < output.objects.size(); i++){
+            fout << output.timeNow << ',' << to_string(output.durationExp) << ',' << output.objects[i].color << ',' 
+                << to_string(output.objects[i].topLeftX_leftCam) << ',' << to_string(output.objects[i].topLeftY_leftCam) << ',' << to_string(output.objects[i].bottomRightX_leftCam) << ',' << to_string(output.objects[i].bottomRightY_leftCam) << ',' 
+                << to_string(output.objects[i].topLeftX_rightCam) << ',' << to_string(output.objects[i].topLeftY_rightCam) << ',' << to_string(output.objects[i].bottomRightX_rightCam) << ',' << to_string(output.objects[i].bottomRightY_rightCam);
             fout <<"\n";
         }
         
@@ -671,18 +733,17 @@ void perceptionThread::saveDataObjects(){
     }   
 }
 
-void perceptionThread::saveDataICubes(){
+void perceptionThread::saveDataICubes(const perceptionOutput& output){
     ofstream fout;
     
-    if(dataAllCubes != NULL){
+    if(output.hasICubes){
         fout.open(filenameAllICubes, ios::app);
-        std::time_t temp = Time::now();
 
-        for(int i = 0; i < dataAllCubes->size(); i++){
-            fout << timeNow << ',' << to_string(temp - timeInitial) << ',' << i << ',' << dataAllCubes->get(i).asList()->get(0).asInt32()<<",";
-            if(dataAllCubes->get(i).asList()->get(1).asList() != NULL)
-                fout<<dataAllCubes->get(i).asList()->get(1).asList()->get(0).asInt32()<<","<<dataAllCubes->get(i).asList()->get(1).asList()->get(1).asInt32()<<","<<dataAllCubes->get(i).asList()->get(1).asList()->get(2).asInt32()<<","<<dataAllCubes->get(i).asList()->get(1).asList()->get(3).asInt32()<<","<<dataAllCubes->get(i).asList()->get(1).asList()->get(4).asInt32()<<","<<dataAllCubes->get(i).asList()->get(1).asList()->get(5).asInt32();
-            fout<<dataAllCubes->get(i).asList()->get(2).asString()<<'\n';
+        for(int i = 0; i < output.iCubes.size(); i++){
+            Bottle* cube = output.iCubes.get(i).asList();
+            unsigned int touchMask = cube->get(ICUBE_TOUCH_MASK).asInt32();
+            fout << output.timeNow << ',' << to_string(output.durationExpICubes) << ',' << i << ',' << cube->get(ICUBE_STATUS).asInt32() << ',' << touchMask << ','
+                << countTouchedFaces(touchMask) << ',' << cube->get(ICUBE_POSE).asString() << '\n';
         }
 
         fout.close();
@@ -696,6 +757,10 @@ bool perceptionThread::processing(){
 
 
 void perceptionThread::threadRelease() {   
+    //the output of the last step is written before closing the ports
+    sensors.stop();
+    outputs.stop();
+
     inputPortBlobsListL.interrupt();
     inputPortBlobsListR.interrupt();
     inputSkinPort.interrupt();
@@ -51,7 +51,7 @@ class sleepingModule:public yarp::os::RFModule {
     
     std::string robotPlatform;
     /*  */
-    sleepingThread *pThread;             // pointer to a new thread to be created and started in configure() and stopped in close()
+    sleepingThread *pThread = nullptr; // pointer to a new thread to be created and started in configure() and stopped in close()
 
 public:
     /**
@@ -37,11 +37,34 @@
 #include <cstring>
 #include <boost/algorithm/string.hpp>
 #include <string.h>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
-#define REDDY_ROBOT     "reddy"
-#define BERRY_ROBOT     "berry"
+#include "iCub/robotExpression.h"
+#include "iCub/connectionBarrier.h"
 
-class sleepingThread : public yarp::os::PeriodicThread {
+#define STATE_AWAKE     0
+#define STATE_ASLEEP    1
+
+class sleepingThread;
+
+//Port that asks the thread to wake up ("wake", or any other message) or to sleep again ("sleep")
+class wakeUpPort : public yarp::os::BufferedPort<yarp::os::Bottle>{
+    private:
+        sleepingThread* thread;
+    public:
+        wakeUpPort();
+        void setThread(sleepingThread* thread_);
+
+        using yarp::os::BufferedPort<yarp::os::Bottle>::onRead;
+        void onRead(yarp::os::Bottle& command) override;
+};
+
+/*  Idle state of the robot: the pose, face and eyelids are set once when it falls asleep, then the thread
+    waits (without polling) for a wake/sleep request or for the time to play the next sleep sound
+*/
+class sleepingThread : public yarp::os::Thread {
 private:
 
     std::string robot;              // name of the robot
@@ -52,21 +75,19 @@ private:
 
     std::string name;  
 
-    int init;
-
     yarp::os::ResourceFinder rf;
-    
-    yarp::os::BufferedPort<yarp::os::Bottle> outputSpeechPort;
 
-    yarp::os::Port outputEmotionsPort;
-
-    yarp::os::RpcClient outputMovementRAPort;
-    yarp::os::RpcClient outputMovementLAPort; 
-    yarp::os::RpcClient outputMovementTPort;
+    std::mutex stateMutex;
+    std::condition_variable stateChanged;
+    int state;
+    int requestedState;
+    double sleepSoundInterval;      //s between two sleep sounds (0 to stay silent)
 
+    wakeUpPort inputWakeUpPort;
+    
+    yarp::os::BufferedPort<yarp::os::Bottle> outputSpeechPort;
 
-    yarp::os::RpcClient outRpcEyelids_berry;  // RPC port to control the eyelids -- Berry
-    yarp::os::RpcClient outRpcEyelids_reddy;  // RPC port to control the eyelids -- Reddy
+    robotExpression expression;     //face LEDs, eyelids (Berry, Reddy) and movements of the arms and torso
 
 public:
     /**
@@ -102,6 +123,20 @@ public:
     */
     void run(); 
 
+    /**
+    *  wakes the thread blocked in run
+    */
+    void onStop();
+
+    /**
+    * ask the thread to change to STATE_AWAKE or STATE_ASLEEP
+    */
+    void requestState(int newState);
+    int getState();
+
+    void fallAsleep();
+    void wakeUp();
+
     /**
     * function that sets the rootname of all the ports that are going to be created by the thread
     * @param str rootnma
@@ -128,13 +163,7 @@ public:
     bool openAllPorts();
     bool waitForPortConnections();
     
-    void executeMovement(const double time, const double offset, const std::string bodyPart, const std::string movement);
-    void setFaceModular(std::string affectEyebr, std::string affectMouth);
     void speakText(std::string speech);
-    
-
-    void moveEyelids(const double time, const double offset, std::string movement);
-    yarp::os::Bottle getEyelidsPose(std::string movement);
 };
 
 #endif  //_SLEEPING_PERIODTHREAD_H_
@@ -124,7 +124,8 @@ bool sleepingModule::close() {
     handlerPort.close();
     /* stop the thread */
     yDebug("stopping the thread \n");
-    pThread->stop();
+    if(pThread != nullptr)
+        pThread->stop();
     return true;
 }
 
@@ -133,19 +134,42 @@ bool sleepingModule::respond(const Bottle& command, Bottle& reply)
     string helpMessage =  string(getName().c_str()) + 
                 " commands are: \n" +  
                 "help \n" +
+                "wake \n" +
+                "sleep \n" +
+                "state \n" +
+                "ready : ok when the module is running (connections done), wait before \n" +
                 "quit \n";
     reply.clear(); 
 
     if (command.get(0).asString()=="quit") {
         reply.addString("quitting");
         //pThread->suspend();
-        pThread->stop();
+        if(pThread != nullptr)
+            pThread->stop();
         return false;     
     }
     else if (command.get(0).asString()=="help") {
         cout << helpMessage;
         reply.addString("ok");
     }
+    else if (command.get(0).asString()=="ready") {
+        reply.addString(pThread != nullptr && pThread->isRunning() ? "ok" : "wait");
+    }
+    //the port is attached before the thread is created
+    else if (pThread == nullptr && (command.get(0).asString()=="wake" || command.get(0).asString()=="sleep" || command.get(0).asString()=="state")) {
+        reply.addString("wait");
+    }
+    else if (command.get(0).asString()=="wake") {
+        pThread->requestState(STATE_AWAKE);
+        reply.addString("ok");
+    }
+    else if (command.get(0).asString()=="sleep") {
+        pThread->requestState(STATE_ASLEEP);
+        reply.addString("ok");
+    }
+    else if (command.get(0).asString()=="state") {
+        reply.addString(pThread->getState() == STATE_ASLEEP ? "asleep" : "awake");
+    }
     
     return true;
 }